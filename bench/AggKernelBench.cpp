@@ -0,0 +1,137 @@
+// AggKernelBench.cpp - throughput of the aggregation kernels (fused sum/min/max/count).
+//
+//   gird_bench_agg [rows]     (default 200,000)
+//
+// Rows are FinancialDataGenerator output tiled up to the requested count. Each
+// kernel set runs over an Int64 and a Double column, both as a contiguous span
+// and gathered through a shuffled row list (what a sorted or filtered
+// vm.indices looks like); the last line is the old getValue loop.
+
+#include "AggKernels.h"
+#include "ColumnStore.h"
+#include "GridFramework.h"
+#include "SimpleRowSource.h"
+#include "FinancialDataGen.h"
+#include "BuildFinancialColumns.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+
+using Clock = std::chrono::steady_clock;
+
+static double Seconds(Clock::time_point a, Clock::time_point b)
+{
+    return std::chrono::duration<double>(b - a).count();
+}
+
+// Best of `reps` runs, in rows per second
+template <class F> static double RowsPerSec(int rows, int reps, F &&run)
+{
+    double best = 1e30;
+    for (int i = 0; i < reps; ++i)
+    {
+        const auto t0 = Clock::now();
+        run();
+        best = std::min(best, Seconds(t0, Clock::now()));
+    }
+    return rows / best;
+}
+
+static bool Same(const gird::AggState &a, const gird::AggState &b)
+{
+    const auto close = [](double x, double y)
+    { return x == y || std::fabs(x - y) <= 1e-9 * std::max(std::fabs(x), std::fabs(y)); };
+    return a.n == b.n && a.isum == b.isum && a.imin == b.imin && a.imax == b.imax &&
+           close(a.sum, b.sum) && a.min == b.min && a.max == b.max;
+}
+
+int main(int argc, char **argv)
+{
+    const int rows = argc > 1 ? std::atoi(argv[1]) : 200000;
+
+    gird::SimpleRowSource src;
+    const auto base = gird::FinancialDataGenerator::GenerateRows();
+    src.rows.reserve(rows);
+    for (int r = 0; r < rows; ++r)
+        src.rows.push_back(base[r % base.size()]);
+
+    gird::GridDocument doc;
+    doc.source = &src;
+    BuildFinancialColumns(doc);
+
+    gird::ColumnStore store;
+    store.Sync(doc);
+    const int i64Col = gird::GridController::FindColumn(doc, "col_11");
+    const int f64Col = gird::GridController::FindColumn(doc, "col_13");
+    const gird::TypedColumn &ci = store.Column(i64Col);
+    const gird::TypedColumn &cf = store.Column(f64Col);
+    if (ci.nullCount > 0 || cf.nullCount > 0)
+        printf("note: columns hold nulls; the kernels read them as values here\n");
+
+    std::vector<int> shuffled(rows);
+    std::iota(shuffled.begin(), shuffled.end(), 0);
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+
+    printf("%d rows (%s, %s)\n\n", rows, doc.columns[i64Col].label.c_str(),
+           doc.columns[f64Col].label.c_str());
+    printf("%-10s %14s %14s %14s %14s\n", "kernels", "i64 span", "i64 gather", "f64 span",
+           "f64 gather");
+
+    const int reps = 10;
+    gird::AggState ref[4];
+    double scalar[4] = {};
+    for (const gird::AggKernels *k : gird::SupportedAggKernels())
+    {
+        gird::AggState out[4];
+        double rate[4];
+        rate[0] = RowsPerSec(rows, reps, [&] { out[0] = {}; k->i64(ci.i64.data(), rows, out[0]); });
+        rate[1] = RowsPerSec(rows, reps,
+                             [&] { out[1] = {}; k->i64Gather(ci.i64.data(), shuffled.data(), rows, out[1]); });
+        rate[2] = RowsPerSec(rows, reps, [&] { out[2] = {}; k->f64(cf.f64.data(), rows, out[2]); });
+        rate[3] = RowsPerSec(rows, reps,
+                             [&] { out[3] = {}; k->f64Gather(cf.f64.data(), shuffled.data(), rows, out[3]); });
+
+        printf("%-10s", k->name);
+        for (int i = 0; i < 4; ++i)
+        {
+            if (scalar[i] == 0)
+            {
+                scalar[i] = rate[i];
+                ref[i] = out[i];
+            }
+            printf(" %8.3g %4.1fx%s", rate[i], rate[i] / scalar[i], Same(out[i], ref[i]) ? "" : "!");
+        }
+        printf("\n");
+    }
+
+    // Reference: the pre-kernel path, one getValue variant per row and aggregate
+    {
+        const auto &def = doc.columns[f64Col];
+        double sum = 0, lo = 0, hi = 0;
+        const double rate = RowsPerSec(rows, 3,
+                                       [&]
+                                       {
+                                           sum = 0;
+                                           lo = INFINITY;
+                                           hi = -INFINITY;
+                                           for (int r : shuffled)
+                                           {
+                                               const gird::Value v = def.getValue(src.rows[r]);
+                                               if (auto p = std::get_if<double>(&v))
+                                               {
+                                                   sum += *p;
+                                                   lo = std::min(lo, *p);
+                                                   hi = std::max(hi, *p);
+                                               }
+                                           }
+                                       });
+        printf("\n%-40s %8.3g rows/s (f64, shuffled)\n", "getValue per row", rate);
+    }
+    printf("\n'!' marks a result that differs from the scalar kernels\n");
+    return 0;
+}
@@ -0,0 +1,117 @@
+// CellTextBench.cpp - per-frame cost of the data cells' text in a scrolling blotter.
+//
+//   gird_bench_cell_text [frames] [ticks per frame]     (default 600, 50)
+//
+// Models what DrawGridImGui formats each frame: a window of VisibleRows rows
+// over all 200 columns, scrolled by a row every few frames, while ticks update
+// random cells in place (SimpleRowSource::SetCell). "format" is the old DataRow
+// path (getValue + format per cell, per frame); "cached" goes through
+// CellTextCache. Times are per frame, formatting only (no ImGui).
+
+#include "CellCache.h"
+#include "GridFramework.h"
+#include "SimpleRowSource.h"
+#include "FinancialDataGen.h"
+#include "BuildFinancialColumns.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string_view>
+
+using Clock = std::chrono::steady_clock;
+
+static double Micros(Clock::time_point a, Clock::time_point b)
+{
+    return std::chrono::duration<double, std::micro>(b - a).count();
+}
+
+static void Report(const char *name, std::vector<double> us)
+{
+    std::sort(us.begin(), us.end());
+    double sum = 0;
+    for (double x : us)
+        sum += x;
+    printf("%-8s mean %8.1f us   p50 %8.1f us   p95 %8.1f us   max %8.1f us\n", name, sum / us.size(),
+           us[us.size() / 2], us[us.size() * 95 / 100], us.back());
+}
+
+int main(int argc, char **argv)
+{
+    const int frames = argc > 1 ? std::atoi(argv[1]) : 600;
+    const int ticks = argc > 2 ? std::atoi(argv[2]) : 50;
+    constexpr int VisibleRows = 45;
+
+    gird::SimpleRowSource src;
+    src.rows = gird::FinancialDataGenerator::GenerateRows();
+    gird::GridDocument doc;
+    doc.source = &src;
+    BuildFinancialColumns(doc);
+    const int rows = src.RowCount();
+    const int cols = static_cast<int>(doc.columns.size());
+    const int tickCol = gird::GridController::FindColumn(doc, "col_17"); // Current Price
+
+    printf("%d rows, %d columns, %d visible rows, %d frames, %d ticks per frame\n\n", rows, cols,
+           VisibleRows, frames, ticks);
+
+    // Same data, scroll and tick sequence for both runs
+    const std::vector<gird::SimpleRow> original = src.rows;
+    auto run = [&](auto &&drawCell)
+    {
+        for (int r = 0; r < rows; ++r)
+            for (int c = 0; c < static_cast<int>(original[r].size()); ++c)
+                src.SetCell(r, c, original[r][c]);
+        std::mt19937 rng(7);
+        std::vector<double> us;
+        size_t sink = 0;
+        int top = 0;
+        for (int f = 0; f < frames; ++f)
+        {
+            if (f % 4 == 0)
+                top = (top + 1) % (rows - VisibleRows);
+            for (int t = 0; t < ticks; ++t)
+            {
+                // Half the ticks land on screen, as on a watched blotter
+                const int r = (t % 2) ? top + static_cast<int>(rng() % VisibleRows)
+                                      : static_cast<int>(rng() % rows);
+                src.SetCell(r, tickCol, gird::Value(static_cast<double>(rng() % 100000) / 100.0));
+            }
+
+            const auto t0 = Clock::now();
+            sink += drawCell(-1, -1); // frame start
+            for (int r = top; r < top + VisibleRows; ++r)
+                for (int c = 0; c < cols; ++c)
+                    sink += drawCell(r, c);
+            us.push_back(Micros(t0, Clock::now()));
+        }
+        return std::make_pair(us, sink);
+    };
+
+    auto [plain, a] = run(
+        [&](int r, int c) -> size_t
+        {
+            if (r < 0)
+                return 0;
+            const gird::ColumnDef &col = doc.columns[c];
+            const gird::Value v = col.getValue ? col.getValue(src.RowAt(r)) : gird::Value(std::string{});
+            return gird::FormatCell(col, v).size();
+        });
+    gird::CellTextCache cache;
+    auto [cached, b] = run(
+        [&](int r, int c) -> size_t
+        {
+            if (r < 0)
+            {
+                cache.BeginFrame(doc);
+                return 0;
+            }
+            return cache.Get(doc, r, c).text.size();
+        });
+
+    Report("format", plain);
+    Report("cached", cached);
+    printf("\ncache: %.1f KB; text bytes %zu / %zu (should match)\n", cache.MemoryBytes() / 1024.0, a, b);
+    return 0;
+}
@@ -0,0 +1,460 @@
+#include "AggKernels.h"
+
+#include <algorithm>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define GIRD_AGG_SSE2 1
+#if defined(__GNUC__) || defined(__clang__)
+// Compiled for AVX2/AVX-512 whatever the build flags; used only if the CPU has them
+#define GIRD_AGG_TARGET(t) __attribute__((target(t)))
+#define GIRD_AGG_AVX2 1
+#define GIRD_AGG_AVX512 1
+#else
+#define GIRD_AGG_TARGET(t)
+#ifdef __AVX2__
+#define GIRD_AGG_AVX2 1
+#endif
+#ifdef __AVX512F__
+#define GIRD_AGG_AVX512 1
+#endif
+#endif
+#endif
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define GIRD_AGG_WASM 1
+#endif
+
+namespace gird
+{
+
+namespace
+{
+
+// ---- Scalar ----
+
+template <class Load> void I64Scalar(Load load, int count, AggState &s)
+{
+    int64_t sum = s.isum, lo = s.imin, hi = s.imax;
+    for (int i = 0; i < count; ++i)
+    {
+        const int64_t x = load(i);
+        sum += x;
+        lo = std::min(lo, x);
+        hi = std::max(hi, x);
+    }
+    s.n += count;
+    s.isum = sum;
+    s.imin = lo;
+    s.imax = hi;
+}
+
+template <class Load> void F64Scalar(Load load, int count, AggState &s)
+{
+    double sum = s.sum, lo = s.min, hi = s.max;
+    for (int i = 0; i < count; ++i)
+    {
+        const double x = load(i);
+        sum += x;
+        lo = std::min(lo, x);
+        hi = std::max(hi, x);
+    }
+    s.n += count;
+    s.sum = sum;
+    s.min = lo;
+    s.max = hi;
+}
+
+void I64SpanScalar(const int64_t *v, int count, AggState &s)
+{
+    I64Scalar([v](int i) { return v[i]; }, count, s);
+}
+
+void I64GatherScalar(const int64_t *v, const int *rows, int count, AggState &s)
+{
+    I64Scalar([v, rows](int i) { return v[rows[i]]; }, count, s);
+}
+
+void F64SpanScalar(const double *v, int count, AggState &s)
+{
+    F64Scalar([v](int i) { return v[i]; }, count, s);
+}
+
+void F64GatherScalar(const double *v, const int *rows, int count, AggState &s)
+{
+    F64Scalar([v, rows](int i) { return v[rows[i]]; }, count, s);
+}
+
+constexpr AggKernels ScalarKernels{"scalar", I64SpanScalar, I64GatherScalar, F64SpanScalar,
+                                   F64GatherScalar};
+
+// Folds vector lanes into the state (the lanes never hold NaN min/max)
+void FoldF64(const double *sum, const double *lo, const double *hi, int lanes, int count, AggState &s)
+{
+    for (int l = 0; l < lanes; ++l)
+    {
+        s.sum += sum[l];
+        s.min = std::min(s.min, lo[l]);
+        s.max = std::max(s.max, hi[l]);
+    }
+    s.n += count;
+}
+
+void FoldI64(const int64_t *sum, const int64_t *lo, const int64_t *hi, int lanes, int count, AggState &s)
+{
+    for (int l = 0; l < lanes; ++l)
+    {
+        s.isum += sum[l];
+        s.imin = std::min(s.imin, lo[l]);
+        s.imax = std::max(s.imax, hi[l]);
+    }
+    s.n += count;
+}
+
+// ---- SSE2 (x86-64 baseline) ----
+// SSE2 has no 64-bit integer compare, so its int64 kernels are the scalar ones.
+#ifdef GIRD_AGG_SSE2
+
+template <class Load> int F64Sse2(Load load, int count, AggState &s)
+{
+    __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+    __m128d lo = _mm_set1_pd(s.min), hi = _mm_set1_pd(s.max);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128d a = load(i), b = load(i + 2);
+        sum0 = _mm_add_pd(sum0, a);
+        sum1 = _mm_add_pd(sum1, b);
+        lo = _mm_min_pd(a, _mm_min_pd(b, lo)); // a NaN operand yields the second
+        hi = _mm_max_pd(a, _mm_max_pd(b, hi));
+    }
+    alignas(16) double sums[2], los[2], his[2];
+    _mm_store_pd(sums, _mm_add_pd(sum0, sum1));
+    _mm_store_pd(los, lo);
+    _mm_store_pd(his, hi);
+    FoldF64(sums, los, his, 2, i, s);
+    return i;
+}
+
+void F64SpanSse2(const double *v, int count, AggState &s)
+{
+    const int done = F64Sse2([v](int i) { return _mm_loadu_pd(v + i); }, count, s);
+    F64SpanScalar(v + done, count - done, s);
+}
+
+void F64GatherSse2(const double *v, const int *rows, int count, AggState &s)
+{
+    const int done =
+        F64Sse2([v, rows](int i) { return _mm_set_pd(v[rows[i + 1]], v[rows[i]]); }, count, s);
+    F64GatherScalar(v, rows + done, count - done, s);
+}
+
+constexpr AggKernels Sse2Kernels{"sse2", I64SpanScalar, I64GatherScalar, F64SpanSse2,
+                                 F64GatherSse2};
+
+#endif
+
+// GCC 12's AVX2/AVX-512 headers trip its own uninitialized-use warnings
+// (gathers and masked ops start from an undefined vector)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// ---- AVX2 ----
+#ifdef GIRD_AGG_AVX2
+
+template <class Load> GIRD_AGG_TARGET("avx2") inline int I64Avx2(Load load, int count, AggState &s)
+{
+    __m256i sum = _mm256_setzero_si256();
+    __m256i lo = _mm256_set1_epi64x(s.imin), hi = _mm256_set1_epi64x(s.imax);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m256i x = load(i);
+        sum = _mm256_add_epi64(sum, x);
+        lo = _mm256_blendv_epi8(lo, x, _mm256_cmpgt_epi64(lo, x));
+        hi = _mm256_blendv_epi8(hi, x, _mm256_cmpgt_epi64(x, hi));
+    }
+    alignas(32) int64_t sums[4], los[4], his[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(sums), sum);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(los), lo);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(his), hi);
+    FoldI64(sums, los, his, 4, i, s);
+    return i;
+}
+
+template <class Load> GIRD_AGG_TARGET("avx2") inline int F64Avx2(Load load, int count, AggState &s)
+{
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    __m256d lo = _mm256_set1_pd(s.min), hi = _mm256_set1_pd(s.max);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256d a = load(i), b = load(i + 4);
+        sum0 = _mm256_add_pd(sum0, a);
+        sum1 = _mm256_add_pd(sum1, b);
+        lo = _mm256_min_pd(a, _mm256_min_pd(b, lo));
+        hi = _mm256_max_pd(a, _mm256_max_pd(b, hi));
+    }
+    alignas(32) double sums[4], los[4], his[4];
+    _mm256_store_pd(sums, _mm256_add_pd(sum0, sum1));
+    _mm256_store_pd(los, lo);
+    _mm256_store_pd(his, hi);
+    FoldF64(sums, los, his, 4, i, s);
+    return i;
+}
+
+GIRD_AGG_TARGET("avx2") void I64SpanAvx2(const int64_t *v, int count, AggState &s)
+{
+    const int done = I64Avx2(
+        [v](int i) GIRD_AGG_TARGET("avx2")
+        { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v + i)); },
+        count, s);
+    I64SpanScalar(v + done, count - done, s);
+}
+
+GIRD_AGG_TARGET("avx2") void I64GatherAvx2(const int64_t *v, const int *rows, int count, AggState &s)
+{
+    const auto *base = reinterpret_cast<const long long *>(v);
+    const int done = I64Avx2(
+        [base, rows](int i) GIRD_AGG_TARGET("avx2")
+        {
+            const __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows + i));
+            return _mm256_i32gather_epi64(base, idx, 8);
+        },
+        count, s);
+    I64GatherScalar(v, rows + done, count - done, s);
+}
+
+GIRD_AGG_TARGET("avx2") void F64SpanAvx2(const double *v, int count, AggState &s)
+{
+    const int done = F64Avx2([v](int i) GIRD_AGG_TARGET("avx2") { return _mm256_loadu_pd(v + i); },
+                             count, s);
+    F64SpanScalar(v + done, count - done, s);
+}
+
+GIRD_AGG_TARGET("avx2") void F64GatherAvx2(const double *v, const int *rows, int count, AggState &s)
+{
+    const int done = F64Avx2(
+        [v, rows](int i) GIRD_AGG_TARGET("avx2")
+        {
+            const __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows + i));
+            return _mm256_i32gather_pd(v, idx, 8);
+        },
+        count, s);
+    F64GatherScalar(v, rows + done, count - done, s);
+}
+
+constexpr AggKernels Avx2Kernels{"avx2", I64SpanAvx2, I64GatherAvx2, F64SpanAvx2, F64GatherAvx2};
+
+#endif
+
+// ---- AVX-512 ----
+#ifdef GIRD_AGG_AVX512
+
+template <class Load> GIRD_AGG_TARGET("avx512f") inline int I64Avx512(Load load, int count, AggState &s)
+{
+    __m512i sum = _mm512_setzero_si512();
+    __m512i lo = _mm512_set1_epi64(s.imin), hi = _mm512_set1_epi64(s.imax);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m512i x = load(i);
+        sum = _mm512_add_epi64(sum, x);
+        lo = _mm512_min_epi64(lo, x);
+        hi = _mm512_max_epi64(hi, x);
+    }
+    alignas(64) int64_t sums[8], los[8], his[8];
+    _mm512_store_si512(sums, sum);
+    _mm512_store_si512(los, lo);
+    _mm512_store_si512(his, hi);
+    FoldI64(sums, los, his, 8, i, s);
+    return i;
+}
+
+template <class Load> GIRD_AGG_TARGET("avx512f") inline int F64Avx512(Load load, int count, AggState &s)
+{
+    __m512d sum0 = _mm512_setzero_pd(), sum1 = _mm512_setzero_pd();
+    __m512d lo = _mm512_set1_pd(s.min), hi = _mm512_set1_pd(s.max);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m512d a = load(i), b = load(i + 8);
+        sum0 = _mm512_add_pd(sum0, a);
+        sum1 = _mm512_add_pd(sum1, b);
+        lo = _mm512_min_pd(a, _mm512_min_pd(b, lo));
+        hi = _mm512_max_pd(a, _mm512_max_pd(b, hi));
+    }
+    alignas(64) double sums[8], los[8], his[8];
+    _mm512_store_pd(sums, _mm512_add_pd(sum0, sum1));
+    _mm512_store_pd(los, lo);
+    _mm512_store_pd(his, hi);
+    FoldF64(sums, los, his, 8, i, s);
+    return i;
+}
+
+GIRD_AGG_TARGET("avx512f") void I64SpanAvx512(const int64_t *v, int count, AggState &s)
+{
+    const int done = I64Avx512([v](int i) GIRD_AGG_TARGET("avx512f") { return _mm512_loadu_si512(v + i); },
+                               count, s);
+    I64SpanScalar(v + done, count - done, s);
+}
+
+GIRD_AGG_TARGET("avx512f") void I64GatherAvx512(const int64_t *v, const int *rows, int count, AggState &s)
+{
+    const int done = I64Avx512(
+        [v, rows](int i) GIRD_AGG_TARGET("avx512f")
+        {
+            const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows + i));
+            return _mm512_i32gather_epi64(idx, v, 8);
+        },
+        count, s);
+    I64GatherScalar(v, rows + done, count - done, s);
+}
+
+GIRD_AGG_TARGET("avx512f") void F64SpanAvx512(const double *v, int count, AggState &s)
+{
+    const int done = F64Avx512([v](int i) GIRD_AGG_TARGET("avx512f") { return _mm512_loadu_pd(v + i); },
+                               count, s);
+    F64SpanScalar(v + done, count - done, s);
+}
+
+GIRD_AGG_TARGET("avx512f") void F64GatherAvx512(const double *v, const int *rows, int count, AggState &s)
+{
+    const int done = F64Avx512(
+        [v, rows](int i) GIRD_AGG_TARGET("avx512f")
+        {
+            const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows + i));
+            return _mm512_i32gather_pd(idx, v, 8);
+        },
+        count, s);
+    F64GatherScalar(v, rows + done, count - done, s);
+}
+
+constexpr AggKernels Avx512Kernels{"avx512", I64SpanAvx512, I64GatherAvx512, F64SpanAvx512,
+                                   F64GatherAvx512};
+
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// ---- WebAssembly SIMD128 ----
+#ifdef GIRD_AGG_WASM
+
+template <class Load> int I64Wasm(Load load, int count, AggState &s)
+{
+    v128_t sum = wasm_i64x2_splat(0);
+    v128_t lo = wasm_i64x2_splat(s.imin), hi = wasm_i64x2_splat(s.imax);
+    int i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        const v128_t x = load(i);
+        sum = wasm_i64x2_add(sum, x);
+        lo = wasm_v128_bitselect(x, lo, wasm_i64x2_gt(lo, x));
+        hi = wasm_v128_bitselect(x, hi, wasm_i64x2_gt(x, hi));
+    }
+    const int64_t sums[2] = {wasm_i64x2_extract_lane(sum, 0), wasm_i64x2_extract_lane(sum, 1)};
+    const int64_t los[2] = {wasm_i64x2_extract_lane(lo, 0), wasm_i64x2_extract_lane(lo, 1)};
+    const int64_t his[2] = {wasm_i64x2_extract_lane(hi, 0), wasm_i64x2_extract_lane(hi, 1)};
+    FoldI64(sums, los, his, 2, i, s);
+    return i;
+}
+
+template <class Load> int F64Wasm(Load load, int count, AggState &s)
+{
+    v128_t sum = wasm_f64x2_splat(0.0);
+    v128_t lo = wasm_f64x2_splat(s.min), hi = wasm_f64x2_splat(s.max);
+    int i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        const v128_t x = load(i);
+        sum = wasm_f64x2_add(sum, x);
+        lo = wasm_f64x2_pmin(lo, x); // x < lo ? x : lo, so NaN keeps lo
+        hi = wasm_f64x2_pmax(hi, x);
+    }
+    const double sums[2] = {wasm_f64x2_extract_lane(sum, 0), wasm_f64x2_extract_lane(sum, 1)};
+    const double los[2] = {wasm_f64x2_extract_lane(lo, 0), wasm_f64x2_extract_lane(lo, 1)};
+    const double his[2] = {wasm_f64x2_extract_lane(hi, 0), wasm_f64x2_extract_lane(hi, 1)};
+    FoldF64(sums, los, his, 2, i, s);
+    return i;
+}
+
+void I64SpanWasm(const int64_t *v, int count, AggState &s)
+{
+    const int done = I64Wasm([v](int i) { return wasm_v128_load(v + i); }, count, s);
+    I64SpanScalar(v + done, count - done, s);
+}
+
+void I64GatherWasm(const int64_t *v, const int *rows, int count, AggState &s)
+{
+    const int done =
+        I64Wasm([v, rows](int i) { return wasm_i64x2_make(v[rows[i]], v[rows[i + 1]]); }, count, s);
+    I64GatherScalar(v, rows + done, count - done, s);
+}
+
+void F64SpanWasm(const double *v, int count, AggState &s)
+{
+    const int done = F64Wasm([v](int i) { return wasm_v128_load(v + i); }, count, s);
+    F64SpanScalar(v + done, count - done, s);
+}
+
+void F64GatherWasm(const double *v, const int *rows, int count, AggState &s)
+{
+    const int done =
+        F64Wasm([v, rows](int i) { return wasm_f64x2_make(v[rows[i]], v[rows[i + 1]]); }, count, s);
+    F64GatherScalar(v, rows + done, count - done, s);
+}
+
+constexpr AggKernels WasmKernels{"simd128", I64SpanWasm, I64GatherWasm, F64SpanWasm, F64GatherWasm};
+
+#endif
+
+bool CpuHas([[maybe_unused]] const char *feature)
+{
+#if defined(GIRD_AGG_SSE2) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (std::string_view(feature) == "avx2")
+        return __builtin_cpu_supports("avx2");
+    if (std::string_view(feature) == "avx512f")
+        return __builtin_cpu_supports("avx512f");
+    return false;
+#else
+    return true; // compiled in only when /arch enables it
+#endif
+}
+
+} // namespace
+
+std::vector<const AggKernels *> SupportedAggKernels()
+{
+    std::vector<const AggKernels *> out{&ScalarKernels};
+#ifdef GIRD_AGG_SSE2
+    out.push_back(&Sse2Kernels);
+#endif
+#ifdef GIRD_AGG_AVX2
+    if (CpuHas("avx2"))
+        out.push_back(&Avx2Kernels);
+#endif
+#ifdef GIRD_AGG_AVX512
+    if (CpuHas("avx512f"))
+        out.push_back(&Avx512Kernels);
+#endif
+#ifdef GIRD_AGG_WASM
+    out.push_back(&WasmKernels);
+#endif
+    return out;
+}
+
+const AggKernels &BestAggKernels()
+{
+    static const AggKernels *best = SupportedAggKernels().back();
+    return *best;
+}
+
+} // namespace gird
@@ -0,0 +1,34 @@
+#pragma once
+#include "Aggregate.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace gird
+{
+
+// ---- Aggregation kernels ----
+// Fused sum/min/max/count over null-free int64 or double values, folded into
+// an AggState: over a contiguous span, or gathered through a row list. Every
+// kernel set computes the same thing; the vector ones keep several partial
+// sums, so double sums can differ from the scalar set in the last bits. NaN
+// values are skipped by min/max and propagate through the sum, as in the
+// scalar code.
+struct AggKernels
+{
+    const char *name;
+    void (*i64)(const int64_t *values, int count, AggState &s);
+    void (*i64Gather)(const int64_t *values, const int *rows, int count, AggState &s);
+    void (*f64)(const double *values, int count, AggState &s);
+    void (*f64Gather)(const double *values, const int *rows, int count, AggState &s);
+};
+
+// Widest kernel set this CPU runs: AVX-512, AVX2 or SSE2 on x86-64 (picked at
+// run time on GCC/Clang, by /arch on MSVC), SIMD128 in a wasm build compiled
+// with -msimd128, scalar otherwise.
+[[nodiscard]] const AggKernels &BestAggKernels();
+
+// Every kernel set this CPU runs, scalar first (benchmarks).
+[[nodiscard]] std::vector<const AggKernels *> SupportedAggKernels();
+
+} // namespace gird
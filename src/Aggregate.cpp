@@ -0,0 +1,502 @@
+#include "Aggregate.h"
+#include "AggKernels.h"
+#include "ColumnStore.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <unordered_map>
+
+namespace gird
+{
+
+AggPlan AggPlan::Resolve(const GridDocument &doc, const GridViewModel &vm, ColumnStore &store)
+{
+    AggPlan plan;
+
+    std::unordered_map<std::string, int> colById;
+    for (int c = 0; c < static_cast<int>(doc.columns.size()); ++c)
+        colById.emplace(doc.columns[c].id, c);
+
+    // One slot per distinct numeric source column, integer sources first
+    std::vector<int> slotOfCol(doc.columns.size(), -1);
+    std::vector<int> f64Cols;
+    for (int vc = 0; vc < static_cast<int>(vm.viewColumns.size()); ++vc)
+    {
+        const ViewColumn &vcol = vm.viewColumns[vc];
+        if (vcol.kind != ViewColumn::Kind::Agg || vcol.pivotKey >= 0)
+            continue; // pivot cells come from the PivotCube
+
+        Output out;
+        out.viewCol = vc;
+        out.type = vcol.agg.type;
+        auto it = colById.find(vcol.agg.column_id);
+        if (it != colById.end())
+        {
+            const int col = it->second;
+            const ValueType t = doc.columns[col].type;
+            const bool numeric = (t == ValueType::Int64 || t == ValueType::Double);
+            out.known = static_cast<bool>(doc.columns[col].getValue);
+            out.integer = (t == ValueType::Int64);
+            out.number = doc.columns[col].number;
+
+            // Approximate types: one sketch per (column, kind)
+            SketchKind kind = SketchKind::Distinct;
+            bool sketch = out.known;
+            switch (out.type)
+            {
+            case AggType::DistinctCount:
+                break;
+            case AggType::Median:
+            case AggType::P95:
+                kind = SketchKind::Quantiles;
+                sketch = sketch && numeric;
+                break;
+            case AggType::TopK:
+                kind = SketchKind::TopK;
+                break;
+            default:
+                sketch = false;
+                break;
+            }
+            if (sketch)
+            {
+                auto same = [&](const SketchSource &k) { return k.docCol == col && k.kind == kind; };
+                auto found = std::find_if(plan.sketches.begin(), plan.sketches.end(), same);
+                out.sketch = static_cast<int>(found - plan.sketches.begin());
+                if (found == plan.sketches.end())
+                    plan.sketches.push_back({&store.Column(col), kind, col});
+            }
+
+            // Custom: the registered aggregator over numeric value (and weight) columns
+            const CustomAggregator *custom = out.type == AggType::Custom && numeric
+                                                 ? FindCustomAggregate(doc, vcol.agg.customAggId)
+                                                 : nullptr;
+            int weightCol = -1;
+            if (custom && custom->Weighted())
+            {
+                auto w = colById.find(vcol.agg.weightColumnId);
+                const bool usable = w != colById.end() && (doc.columns[w->second].type == ValueType::Int64 ||
+                                                           doc.columns[w->second].type == ValueType::Double);
+                weightCol = usable ? w->second : -1;
+                if (weightCol < 0)
+                    custom = nullptr;
+            }
+            if (custom)
+            {
+                auto same = [&](const CustomSource &k)
+                { return k.agg == custom && k.valueCol == col && k.weightCol == weightCol; };
+                auto found = std::find_if(plan.customs.begin(), plan.customs.end(), same);
+                out.custom = static_cast<int>(found - plan.customs.begin());
+                if (found == plan.customs.end())
+                    plan.customs.push_back({custom, &store.Column(col),
+                                            weightCol >= 0 ? &store.Column(weightCol) : nullptr, col,
+                                            weightCol});
+            }
+
+            const bool exact = out.type == AggType::Min || out.type == AggType::Max ||
+                               out.type == AggType::Sum || out.type == AggType::Avg;
+            if (exact && numeric)
+            {
+                if (slotOfCol[col] < 0)
+                {
+                    slotOfCol[col] = -2; // assigned below
+                    if (t == ValueType::Int64)
+                        plan.sources.push_back({&store.Column(col), col});
+                    else
+                        f64Cols.push_back(col);
+                }
+                out.slot = col; // column for now, remapped to its slot below
+            }
+        }
+        plan.outputs.push_back(out);
+    }
+    plan.i64Sources = static_cast<int>(plan.sources.size());
+    for (int col : f64Cols)
+        plan.sources.push_back({&store.Column(col), col});
+
+    for (int s = 0; s < static_cast<int>(plan.sources.size()); ++s)
+        slotOfCol[plan.sources[s].docCol] = s;
+    for (Output &out : plan.outputs)
+        if (out.slot >= 0)
+            out.slot = slotOfCol[out.slot];
+    return plan;
+}
+
+namespace
+{
+
+void AddI64(int64_t x, AggState &st)
+{
+    ++st.n;
+    st.isum += x;
+    st.imin = std::min(st.imin, x);
+    st.imax = std::max(st.imax, x);
+}
+
+void AddF64(double x, AggState &st)
+{
+    ++st.n;
+    st.sum += x;
+    st.min = std::min(st.min, x);
+    st.max = std::max(st.max, x);
+}
+
+double NumberAt(const TypedColumn &c, int row)
+{
+    return c.type == ValueType::Int64 ? static_cast<double>(c.i64[row]) : c.f64[row];
+}
+
+// The slot's sketch, created on its first row
+template <class S> S &Use(SketchState &st)
+{
+    if (S *s = std::get_if<S>(&st))
+        return *s;
+    return st.emplace<S>();
+}
+
+// Identity of a cell for distinct counts and top-k: the value itself, or its
+// dictionary code for String and Date columns
+int64_t KeyOf(const TypedColumn &c, int row)
+{
+    switch (c.type)
+    {
+    case ValueType::Int64:
+    case ValueType::Bool:
+        return c.i64[row];
+    case ValueType::Double:
+    {
+        const double x = c.f64[row];
+        return std::bit_cast<int64_t>(x == 0.0 ? 0.0 : x); // -0 and +0 are one value
+    }
+    case ValueType::String:
+    case ValueType::Date:
+    default:
+        return c.codes[row];
+    }
+}
+
+std::string KeyText(const TypedColumn &c, int64_t key, const NumberFormat &fmt)
+{
+    switch (c.type)
+    {
+    case ValueType::Int64:
+        return IntegerText(key, fmt);
+    case ValueType::Bool:
+        return key ? "true" : "false";
+    case ValueType::Double:
+        return NumberText(std::bit_cast<double>(key), fmt);
+    case ValueType::String:
+    case ValueType::Date:
+    default:
+        return key >= 0 && key < static_cast<int64_t>(c.dict.size()) ? c.dict[key] : std::string{};
+    }
+}
+
+} // namespace
+
+bool AggPlan::SameLayout(const AggPlan &other) const
+{
+    return sources == other.sources && i64Sources == other.i64Sources && sketches == other.sketches &&
+           customs == other.customs;
+}
+
+std::vector<int> AggPlan::Columns() const
+{
+    std::vector<int> cols;
+    for (const Source &src : sources)
+        cols.push_back(src.docCol);
+    for (const SketchSource &src : sketches)
+        cols.push_back(src.docCol);
+    for (const CustomSource &src : customs)
+    {
+        cols.push_back(src.valueCol);
+        if (src.weightCol >= 0)
+            cols.push_back(src.weightCol);
+    }
+    return cols;
+}
+
+void AggPlan::Accumulate(int row, AggState *states) const
+{
+    for (int s = 0; s < i64Sources; ++s)
+    {
+        const TypedColumn &c = *sources[s].col;
+        if (c.nullCount == 0 || !c.nulls.Test(row))
+            AddI64(c.i64[row], states[s]);
+    }
+    for (int s = i64Sources; s < static_cast<int>(sources.size()); ++s)
+    {
+        const TypedColumn &c = *sources[s].col;
+        if (c.nullCount == 0 || !c.nulls.Test(row))
+            AddF64(c.f64[row], states[s]);
+    }
+}
+
+void AggPlan::Accumulate(const int *rows, int count, AggState *states, SketchState *sketchStates,
+                         CustomState *customStates) const
+{
+    AccumulateSketches(rows, 0, count, sketchStates);
+    AccumulateCustoms(rows, 0, count, customStates);
+    if (sources.empty())
+        return;
+
+    // Blocks of the row list stay in cache while every source column reads them
+    const AggKernels &k = BestAggKernels();
+    for (int b = 0; b < count; b += BlockRows)
+    {
+        const int *block = rows + b;
+        const int m = std::min(BlockRows, count - b);
+        for (int s = 0; s < static_cast<int>(sources.size()); ++s)
+        {
+            const TypedColumn &c = *sources[s].col;
+            const bool integer = s < i64Sources;
+            if (c.nullCount == 0)
+            {
+                if (integer)
+                    k.i64Gather(c.i64.data(), block, m, states[s]);
+                else
+                    k.f64Gather(c.f64.data(), block, m, states[s]);
+                continue;
+            }
+            for (int i = 0; i < m; ++i)
+                if (!c.nulls.Test(block[i]))
+                    integer ? AddI64(c.i64[block[i]], states[s]) : AddF64(c.f64[block[i]], states[s]);
+        }
+    }
+}
+
+void AggPlan::AccumulateRange(int first, int count, AggState *states, SketchState *sketchStates,
+                              CustomState *customStates) const
+{
+    AccumulateSketches(nullptr, first, count, sketchStates);
+    AccumulateCustoms(nullptr, first, count, customStates);
+    const AggKernels &k = BestAggKernels();
+    for (int s = 0; s < static_cast<int>(sources.size()); ++s)
+    {
+        const TypedColumn &c = *sources[s].col;
+        const bool integer = s < i64Sources;
+        if (c.nullCount == 0)
+        {
+            if (integer)
+                k.i64(c.i64.data() + first, count, states[s]);
+            else
+                k.f64(c.f64.data() + first, count, states[s]);
+            continue;
+        }
+        for (int r = first; r < first + count; ++r)
+            if (!c.nulls.Test(r))
+                integer ? AddI64(c.i64[r], states[s]) : AddF64(c.f64[r], states[s]);
+    }
+}
+
+// Rows of `rows` (or first + i without a list), nulls skipped, into each
+// sketch slot; one column at a time
+void AggPlan::AccumulateSketches(const int *rows, int first, int count,
+                                 SketchState *sketchStates) const
+{
+    for (size_t k = 0; k < sketches.size(); ++k)
+    {
+        const TypedColumn &c = *sketches[k].col;
+        auto each = [&](auto &&add)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                const int r = rows ? rows[i] : first + i;
+                if (c.nullCount == 0 || !c.nulls.Test(r))
+                    add(r);
+            }
+        };
+        switch (sketches[k].kind)
+        {
+        case SketchKind::Distinct:
+        {
+            DistinctSketch &s = Use<DistinctSketch>(sketchStates[k]);
+            each([&](int r) { s.Add(HashKey(static_cast<uint64_t>(KeyOf(c, r)))); });
+            break;
+        }
+        case SketchKind::Quantiles:
+        {
+            QuantileSketch &s = Use<QuantileSketch>(sketchStates[k]);
+            if (c.type == ValueType::Int64)
+                each([&](int r) { s.Add(static_cast<double>(c.i64[r])); });
+            else
+                each([&](int r) { s.Add(c.f64[r]); });
+            break;
+        }
+        case SketchKind::TopK:
+        {
+            TopKSketch &s = Use<TopKSketch>(sketchStates[k]);
+            each([&](int r) { s.Add(KeyOf(c, r)); });
+            break;
+        }
+        }
+    }
+}
+
+// Each block's non-null values (and weights) are packed into contiguous arrays
+// and handed to the aggregator in one call
+void AggPlan::AccumulateCustoms(const int *rows, int first, int count,
+                                CustomState *customStates) const
+{
+    if (customs.empty())
+        return;
+
+    double values[BlockRows];
+    double weights[BlockRows];
+    for (size_t k = 0; k < customs.size(); ++k)
+    {
+        const CustomSource &src = customs[k];
+        const TypedColumn &v = *src.values;
+        const TypedColumn *w = src.weights;
+        const bool nulls = v.nullCount > 0 || (w && w->nullCount > 0);
+        for (int b = 0; b < count; b += BlockRows)
+        {
+            const int m = std::min(BlockRows, count - b);
+            int n = 0;
+            for (int i = 0; i < m; ++i)
+            {
+                const int r = rows ? rows[b + i] : first + b + i;
+                if (nulls && ((v.nullCount > 0 && v.nulls.Test(r)) ||
+                              (w && w->nullCount > 0 && w->nulls.Test(r))))
+                    continue;
+                values[n] = NumberAt(v, r);
+                if (w)
+                    weights[n] = NumberAt(*w, r);
+                ++n;
+            }
+            if (n > 0)
+                src.agg->Update(values, w ? weights : nullptr, n, customStates[k]);
+        }
+    }
+}
+
+void AggPlan::Merge(const AggState *from, const SketchState *fromSketches, const CustomState *fromCustoms,
+                    AggState *states, SketchState *sketchStates, CustomState *customStates) const
+{
+    for (size_t s = 0; s < sources.size(); ++s)
+        MergeState(states[s], from[s]);
+    for (size_t k = 0; k < sketches.size(); ++k)
+        MergeSketch(sketchStates[k], fromSketches[k]);
+    for (size_t k = 0; k < customs.size(); ++k)
+        customs[k].agg->Merge(customStates[k], fromCustoms[k]);
+}
+
+std::string AggPlan::ErrorNote(AggType type)
+{
+    char note[160];
+    switch (type)
+    {
+    case AggType::DistinctCount:
+        std::snprintf(note, sizeof note,
+                      "HyperLogLog estimate: exact up to %d distinct values, then +/-%.1f%% "
+                      "(one standard error)",
+                      DistinctSketch::SparseLimit, DistinctSketch::RelativeError * 100.0);
+        return note;
+    case AggType::Median:
+    case AggType::P95:
+        std::snprintf(note, sizeof note,
+                      "KLL quantile: exact up to %d values, then within +/-%.2f%% of rank "
+                      "(99%% confidence)",
+                      QuantileSketch::K, QuantileSketch::RankError * 100.0);
+        return note;
+    case AggType::TopK:
+        std::snprintf(note, sizeof note,
+                      "Space-saving, %d counters: a ~count may overstate by up to rows / %d",
+                      TopKSketch::Counters, TopKSketch::Counters);
+        return note;
+    default:
+        return {};
+    }
+}
+
+void AggPlan::Format(const AggState *states, const SketchState *sketchStates,
+                     const CustomState *customStates, int64_t rows,
+                     std::vector<std::string> &summaryByCol) const
+{
+    char buf[MaxNumberChars];
+    for (const Output &out : outputs)
+    {
+        std::string &text = summaryByCol[out.viewCol];
+        text.clear();
+        // Values in the column's own format; integer columns ignore its precision
+        auto whole = [&](int64_t v) { text.append(buf, FormatInteger(v, out.number, buf)); };
+        auto value = [&](double v) { text.append(buf, FormatNumber(v, out.number, buf)); };
+        auto count = [&](int64_t c) { text.append(buf, FormatInteger(c, CountFormat, buf)); };
+
+        // Count works for any type
+        if (out.type == AggType::Count)
+        {
+            if (out.known)
+                count(rows);
+            continue;
+        }
+
+        if (out.custom >= 0)
+        {
+            text = customs[out.custom].agg->Finalize(customStates[out.custom], out.number);
+            continue;
+        }
+
+        // Approximate values carry a leading "~" once the sketch is no longer exact
+        if (out.sketch >= 0)
+        {
+            const SketchState &st = sketchStates[out.sketch];
+            if (const auto *d = std::get_if<DistinctSketch>(&st))
+            {
+                if (!d->Exact())
+                    text = "~";
+                count(std::llround(d->Estimate()));
+            }
+            else if (const auto *q = std::get_if<QuantileSketch>(&st); q && q->Count() > 0)
+            {
+                if (!q->Exact())
+                    text = "~";
+                const double v = q->Quantile(out.type == AggType::Median ? 0.5 : 0.95);
+                if (out.integer)
+                    whole(std::llround(v));
+                else
+                    value(v);
+            }
+            else if (const auto *t = std::get_if<TopKSketch>(&st))
+            {
+                const TypedColumn &c = *sketches[out.sketch].col;
+                for (const TopKSketch::Item &item : t->Top(3))
+                {
+                    if (!text.empty())
+                        text += ", ";
+                    text += KeyText(c, item.key, out.number);
+                    text += item.error > 0 ? " (~" : " (";
+                    count(item.count);
+                    text += ')';
+                }
+            }
+            continue;
+        }
+        if (out.slot < 0 || states[out.slot].n == 0)
+            continue;
+
+        const AggState &s = states[out.slot];
+        switch (out.type)
+        {
+        case AggType::Min:
+            out.integer ? whole(s.imin) : value(s.min);
+            break;
+        case AggType::Max:
+            out.integer ? whole(s.imax) : value(s.max);
+            break;
+        case AggType::Sum:
+            out.integer ? whole(s.isum) : value(s.sum);
+            break;
+        case AggType::Avg:
+            // An average of integers keeps its fraction
+            value((out.integer ? static_cast<double>(s.isum) : s.sum) / static_cast<double>(s.n));
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+} // namespace gird
@@ -0,0 +1,146 @@
+#pragma once
+#include "CustomAggregate.h"
+#include "GridFramework.h"
+#include "Sketch.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace gird
+{
+
+struct TypedColumn;
+
+// ---- Aggregate state ----
+// Running state of one numeric source column over a set of rows; the same
+// state answers Sum, Min, Max and Avg. Int64 columns accumulate exactly in the
+// integer fields, Double columns in the double ones; `n` counts the non-null
+// values seen, so Avg = sum / n.
+struct AggState
+{
+    int64_t n = 0;
+    int64_t isum = 0;
+    int64_t imin = std::numeric_limits<int64_t>::max();
+    int64_t imax = std::numeric_limits<int64_t>::min();
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+};
+
+// Folds a disjoint set's state into `into` (the result is as if its rows had
+// been accumulated directly; double sums may differ in the last bits).
+inline void MergeState(AggState &into, const AggState &from)
+{
+    into.n += from.n;
+    into.isum += from.isum;
+    into.imin = std::min(into.imin, from.imin);
+    into.imax = std::max(into.imax, from.imax);
+    into.sum += from.sum;
+    into.min = std::min(into.min, from.min);
+    into.max = std::max(into.max, from.max);
+}
+
+// ---- Fused aggregate plan ----
+// All aggregate view columns resolved once against the column store. Every
+// distinct numeric source column gets one state slot, so a row costs one load
+// and one update per source column however many aggregates read it. Row lists
+// are taken a cache-sized block at a time, each block run through the vector
+// kernels (AggKernels.h) of every null-free source column; columns with nulls
+// take the scalar path.
+//
+// Approximate aggregates get sketch slots instead, one per source column and
+// sketch kind (Median and P95 of a column share one quantile sketch), kept in
+// a separate SketchSlots() array beside the states. Custom aggregates get one
+// CustomSlots() entry per (aggregator, value column, weight column), fed a
+// gathered block at a time.
+class AggPlan
+{
+  public:
+    static AggPlan Resolve(const GridDocument &doc, const GridViewModel &vm, ColumnStore &store);
+
+    [[nodiscard]] size_t Slots() const { return sources.size(); }
+    [[nodiscard]] size_t SketchSlots() const { return sketches.size(); }
+    [[nodiscard]] size_t CustomSlots() const { return customs.size(); }
+    [[nodiscard]] bool Empty() const { return outputs.empty(); }
+    // Same states, sketches and custom states in the same slots as `other`, so
+    // states accumulated under one plan can be merged and formatted by the other.
+    [[nodiscard]] bool SameLayout(const AggPlan &other) const;
+    // Doc columns the states are read from (duplicates possible).
+    [[nodiscard]] std::vector<int> Columns() const;
+
+    // Folds rows into `states` (Slots() entries), `sketchStates` (SketchSlots()
+    // entries) and `customStates` (CustomSlots() entries).
+    void Accumulate(int row, AggState *states) const;
+    void Accumulate(const int *rows, int count, AggState *states, SketchState *sketchStates,
+                    CustomState *customStates) const;
+    // Source rows [first, first + count): contiguous loads, no row list.
+    void AccumulateRange(int first, int count, AggState *states, SketchState *sketchStates,
+                         CustomState *customStates) const;
+    // Folds another row set's states, sketches and custom states into these.
+    void Merge(const AggState *from, const SketchState *fromSketches, const CustomState *fromCustoms,
+               AggState *states, SketchState *sketchStates, CustomState *customStates) const;
+
+    // Writes each aggregate's text over `rows` rows into its view column slot.
+    void Format(const AggState *states, const SketchState *sketchStates,
+                const CustomState *customStates, int64_t rows,
+                std::vector<std::string> &summaryByCol) const;
+
+    // Header tooltip of an aggregate type: its error bound; empty when exact.
+    [[nodiscard]] static std::string ErrorNote(AggType type);
+
+  private:
+    static constexpr int BlockRows = 2048;
+
+    struct Source
+    {
+        const TypedColumn *col = nullptr; // Int64 or Double; slot = position in sources
+        int docCol = -1;
+        bool operator==(const Source &) const = default;
+    };
+    enum class SketchKind
+    {
+        Distinct,
+        Quantiles,
+        TopK
+    };
+    struct SketchSource
+    {
+        const TypedColumn *col = nullptr; // any type (Quantiles: Int64 or Double)
+        SketchKind kind = SketchKind::Distinct;
+        int docCol = -1;
+        bool operator==(const SketchSource &) const = default;
+    };
+    struct CustomSource
+    {
+        const CustomAggregator *agg = nullptr;
+        const TypedColumn *values = nullptr;  // Int64 or Double
+        const TypedColumn *weights = nullptr; // Int64 or Double; null = unweighted
+        int valueCol = -1, weightCol = -1;
+        bool operator==(const CustomSource &) const = default;
+    };
+    struct Output
+    {
+        int viewCol = -1;
+        AggType type = AggType::Count;
+        bool known = false; // source column exists (Count needs nothing else)
+        int slot = -1;      // state slot; -1 = not numeric (Count only)
+        int sketch = -1;    // sketch slot of approximate types
+        int custom = -1;    // custom slot of AggType::Custom
+        bool integer = false;
+        NumberFormat number; // the source column's
+    };
+
+    void AccumulateSketches(const int *rows, int first, int count, SketchState *sketchStates) const;
+    void AccumulateCustoms(const int *rows, int first, int count, CustomState *customStates) const;
+
+    std::vector<Source> sources;  // i64 sources first, then f64 (slot order)
+    int i64Sources = 0;
+    std::vector<SketchSource> sketches;
+    std::vector<CustomSource> customs;
+    std::vector<Output> outputs;
+};
+
+} // namespace gird
@@ -0,0 +1,87 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gird
+{
+
+// ---- Dense selection bitmap (bit i set = source row i selected) ----
+// Combined word-parallel; bits past `size` are always kept zero so Count()
+// and the word loops never need a tail case.
+struct Bitmap
+{
+    std::vector<uint64_t> words;
+    int size = 0;
+
+    Bitmap() = default;
+    explicit Bitmap(int n, bool fill = false) { Resize(n, fill); }
+
+    static int WordCount(int n) { return (n + 63) >> 6; }
+
+    void Resize(int n, bool fill)
+    {
+        size = n;
+        words.assign(WordCount(n), fill ? ~uint64_t(0) : 0);
+        ClearTail();
+    }
+
+    void ClearTail()
+    {
+        if (const int rem = size & 63; rem != 0 && !words.empty())
+            words.back() &= (uint64_t(1) << rem) - 1;
+    }
+
+    void Set(int i) { words[i >> 6] |= uint64_t(1) << (i & 63); }
+    void Reset(int i) { words[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+    [[nodiscard]] bool Test(int i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+
+    void And(const Bitmap &o)
+    {
+        for (size_t w = 0; w < words.size(); ++w)
+            words[w] &= o.words[w];
+    }
+    void Or(const Bitmap &o)
+    {
+        for (size_t w = 0; w < words.size(); ++w)
+            words[w] |= o.words[w];
+    }
+    void AndNot(const Bitmap &o)
+    {
+        for (size_t w = 0; w < words.size(); ++w)
+            words[w] &= ~o.words[w];
+    }
+
+    [[nodiscard]] int Count() const
+    {
+        int n = 0;
+        for (uint64_t w : words)
+            n += std::popcount(w);
+        return n;
+    }
+
+    // Calls f(row) for every set bit, in ascending row order.
+    template <class F> void ForEach(F &&f) const
+    {
+        for (size_t w = 0; w < words.size(); ++w)
+        {
+            uint64_t bits = words[w];
+            while (bits)
+            {
+                f(static_cast<int>(w * 64) + std::countr_zero(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // Compacts the selection into a row index list (the one final pass).
+    void ToIndices(std::vector<int> &out) const
+    {
+        out.resize(Count());
+        int *dst = out.data();
+        ForEach([&](int row) { *dst++ = row; });
+    }
+};
+
+} // namespace gird
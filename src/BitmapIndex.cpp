@@ -0,0 +1,274 @@
+#include "BitmapIndex.h"
+#include "ColumnStore.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+
+namespace gird
+{
+
+// ============================================================
+// RoaringBitmap
+// ============================================================
+
+RoaringBitmap::Container *RoaringBitmap::Find(uint16_t key)
+{
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                               [](const Container &c, uint16_t k) { return c.key < k; });
+    return (it != containers.end() && it->key == key) ? &*it : nullptr;
+}
+
+const RoaringBitmap::Container *RoaringBitmap::Find(uint16_t key) const
+{
+    return const_cast<RoaringBitmap *>(this)->Find(key);
+}
+
+void RoaringBitmap::Add(uint32_t x)
+{
+    const auto key = static_cast<uint16_t>(x >> 16);
+    const auto low = static_cast<uint16_t>(x & 0xFFFF);
+
+    // Fast path: ascending appends (index builds walk rows in order)
+    Container *c = (!containers.empty() && containers.back().key == key) ? &containers.back()
+                                                                          : Find(key);
+    if (!c)
+    {
+        auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                                   [](const Container &k, uint16_t v) { return k.key < v; });
+        it = containers.insert(it, Container{});
+        it->key = key;
+        c = &*it;
+    }
+
+    if (!c->bits.empty())
+    {
+        uint64_t &w = c->bits[low >> 6];
+        const uint64_t m = uint64_t(1) << (low & 63);
+        c->cardinality += (w & m) ? 0 : 1;
+        w |= m;
+        return;
+    }
+
+    if (c->array.empty() || c->array.back() < low)
+        c->array.push_back(low);
+    else
+    {
+        auto pos = std::lower_bound(c->array.begin(), c->array.end(), low);
+        if (*pos == low)
+            return;
+        c->array.insert(pos, low);
+    }
+    ++c->cardinality;
+
+    if (c->cardinality > kArrayMax)
+    {
+        c->bits.assign(kBitsetWords, 0);
+        for (uint16_t v : c->array)
+            c->bits[v >> 6] |= uint64_t(1) << (v & 63);
+        c->array = {};
+    }
+}
+
+void RoaringBitmap::Remove(uint32_t x)
+{
+    Container *c = Find(static_cast<uint16_t>(x >> 16));
+    if (!c)
+        return;
+    const auto low = static_cast<uint16_t>(x & 0xFFFF);
+
+    if (!c->bits.empty())
+    {
+        uint64_t &w = c->bits[low >> 6];
+        const uint64_t m = uint64_t(1) << (low & 63);
+        if (!(w & m))
+            return;
+        w &= ~m;
+        if (--c->cardinality <= kArrayMax)
+        {
+            for (int i = 0; i < kBitsetWords; ++i)
+                for (uint64_t b = c->bits[i]; b; b &= b - 1)
+                    c->array.push_back(static_cast<uint16_t>(i * 64 + std::countr_zero(b)));
+            c->bits = {};
+        }
+    }
+    else
+    {
+        auto pos = std::lower_bound(c->array.begin(), c->array.end(), low);
+        if (pos == c->array.end() || *pos != low)
+            return;
+        c->array.erase(pos);
+        --c->cardinality;
+    }
+
+    if (c->cardinality == 0)
+        containers.erase(containers.begin() + (c - containers.data()));
+}
+
+bool RoaringBitmap::Contains(uint32_t x) const
+{
+    const Container *c = Find(static_cast<uint16_t>(x >> 16));
+    if (!c)
+        return false;
+    const auto low = static_cast<uint16_t>(x & 0xFFFF);
+    if (!c->bits.empty())
+        return (c->bits[low >> 6] >> (low & 63)) & 1;
+    return std::binary_search(c->array.begin(), c->array.end(), low);
+}
+
+int RoaringBitmap::Cardinality() const
+{
+    int n = 0;
+    for (const auto &c : containers)
+        n += c.cardinality;
+    return n;
+}
+
+size_t RoaringBitmap::MemoryBytes() const
+{
+    size_t bytes = containers.capacity() * sizeof(Container);
+    for (const auto &c : containers)
+        bytes += c.array.capacity() * sizeof(uint16_t) + c.bits.capacity() * sizeof(uint64_t);
+    return bytes;
+}
+
+void RoaringBitmap::OrInto(Bitmap &dense) const
+{
+    for (const auto &c : containers)
+    {
+        const size_t base = static_cast<size_t>(c.key) << 16;
+        if (!c.bits.empty())
+        {
+            // 65536-bit container lines up with 1024 dense words
+            const size_t w0 = base >> 6;
+            const size_t lim = std::min<size_t>(kBitsetWords, dense.words.size() - w0);
+            for (size_t i = 0; i < lim; ++i)
+                dense.words[w0 + i] |= c.bits[i];
+        }
+        else
+        {
+            for (uint16_t v : c.array)
+                dense.Set(static_cast<int>(base + v));
+        }
+    }
+}
+
+int RoaringBitmap::AndCardinality(const Bitmap &dense) const
+{
+    int n = 0;
+    for (const auto &c : containers)
+    {
+        const size_t base = static_cast<size_t>(c.key) << 16;
+        if (!c.bits.empty())
+        {
+            const size_t w0 = base >> 6;
+            const size_t lim = std::min<size_t>(kBitsetWords, dense.words.size() - w0);
+            for (size_t i = 0; i < lim; ++i)
+                n += std::popcount(dense.words[w0 + i] & c.bits[i]);
+        }
+        else
+        {
+            for (uint16_t v : c.array)
+                n += dense.Test(static_cast<int>(base + v));
+        }
+    }
+    return n;
+}
+
+// ============================================================
+// BitmapIndex
+// ============================================================
+
+static bool IsIntKeyed(const TypedColumn &col)
+{
+    return col.type == ValueType::Int64 || col.type == ValueType::Bool;
+}
+
+void BitmapIndex::Build(const TypedColumn &col)
+{
+    rowsByKey.clear();
+    intKeys.clear();
+    intKeyIndex.clear();
+    if (!IsIntKeyed(col))
+        rowsByKey.resize(col.dict.size());
+
+    const int n = IsIntKeyed(col) ? static_cast<int>(col.i64.size())
+                                  : static_cast<int>(col.codes.size());
+    for (int r = 0; r < n; ++r)
+    {
+        uint32_t key = 0;
+        if (KeyOfRow(col, r, key))
+            AddRow(key, r);
+    }
+}
+
+bool BitmapIndex::KeyOfRow(const TypedColumn &col, int row, uint32_t &key)
+{
+    if (col.nullCount > 0 && col.nulls.Test(row))
+        return false;
+    if (!IsIntKeyed(col))
+    {
+        key = col.codes[row];
+        return true;
+    }
+
+    const int64_t v = col.i64[row];
+    auto [it, inserted] = intKeyIndex.try_emplace(v, static_cast<uint32_t>(intKeys.size()));
+    if (inserted)
+        intKeys.push_back(v);
+    key = it->second;
+    return true;
+}
+
+bool BitmapIndex::KeyOfText(const TypedColumn &col, const std::string &text, uint32_t &key) const
+{
+    if (!IsIntKeyed(col))
+    {
+        auto it = col.dictIndex.find(text);
+        if (it == col.dictIndex.end())
+            return false;
+        key = it->second;
+        return true;
+    }
+
+    int64_t v = 0;
+    if (col.type == ValueType::Bool && (text == "true" || text == "false"))
+        v = (text == "true");
+    else
+    {
+        // Whole integers only: "1.5" or "2e3" cannot equal a key
+        const char *last = text.data() + text.size();
+        const auto [end, ec] = std::from_chars(text.data(), last, v);
+        if (ec != std::errc{} || end != last)
+            return false;
+    }
+    auto it = intKeyIndex.find(v);
+    if (it == intKeyIndex.end())
+        return false;
+    key = it->second;
+    return true;
+}
+
+std::string BitmapIndex::KeyLabel(const TypedColumn &col, uint32_t key) const
+{
+    if (!IsIntKeyed(col))
+        return col.dict[key];
+    if (col.type == ValueType::Bool)
+        return intKeys[key] ? "true" : "false";
+    return std::to_string(intKeys[key]);
+}
+
+void BitmapIndex::AddRow(uint32_t key, int row)
+{
+    if (key >= rowsByKey.size())
+        rowsByKey.resize(key + 1);
+    rowsByKey[key].Add(static_cast<uint32_t>(row));
+}
+
+void BitmapIndex::RemoveRow(uint32_t key, int row)
+{
+    if (key < rowsByKey.size())
+        rowsByKey[key].Remove(static_cast<uint32_t>(row));
+}
+
+} // namespace gird
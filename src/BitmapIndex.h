@@ -0,0 +1,72 @@
+#pragma once
+#include "Bitmap.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gird
+{
+
+struct TypedColumn;
+
+// ---- Compressed row set (roaring layout) ----
+// Rows are split by their high 16 bits into containers; a container stores its
+// low 16 bits as a sorted array while sparse (<= 4096 rows) and as a 65536-bit
+// bitmap once dense, so low-cardinality keys stay small and big ones stay fast.
+class RoaringBitmap
+{
+  public:
+    void Add(uint32_t x);
+    void Remove(uint32_t x);
+    [[nodiscard]] bool Contains(uint32_t x) const;
+    [[nodiscard]] int Cardinality() const;
+    [[nodiscard]] size_t MemoryBytes() const;
+
+    // dense |= this
+    void OrInto(Bitmap &dense) const;
+    // |this & dense|, without materializing the intersection
+    [[nodiscard]] int AndCardinality(const Bitmap &dense) const;
+
+  private:
+    static constexpr int kArrayMax = 4096;
+    static constexpr int kBitsetWords = 1024;
+
+    struct Container
+    {
+        uint16_t key = 0; // high 16 bits
+        int cardinality = 0;
+        std::vector<uint16_t> array; // sorted low bits (sparse form)
+        std::vector<uint64_t> bits;  // kBitsetWords words (dense form)
+    };
+
+    std::vector<Container> containers; // sorted by key
+
+    Container *Find(uint16_t key);
+    [[nodiscard]] const Container *Find(uint16_t key) const;
+};
+
+// ---- Bitmap index: one row set per distinct value of a column ----
+// String/Date columns key by dictionary code; Int64/Bool columns by their own
+// value dictionary. Null cells are not indexed.
+struct BitmapIndex
+{
+    std::vector<RoaringBitmap> rowsByKey;
+    std::vector<int64_t> intKeys;                      // Int64/Bool: key -> value
+    std::unordered_map<int64_t, uint32_t> intKeyIndex; // Int64/Bool: value -> key
+
+    void Build(const TypedColumn &col);
+
+    // Key of the cell at `row` (call before/after patching the column to move a row).
+    [[nodiscard]] bool KeyOfRow(const TypedColumn &col, int row, uint32_t &key);
+    // Key for a user-typed value ("EMEA", "42"); false if absent from the column.
+    [[nodiscard]] bool KeyOfText(const TypedColumn &col, const std::string &text,
+                                 uint32_t &key) const;
+    [[nodiscard]] std::string KeyLabel(const TypedColumn &col, uint32_t key) const;
+
+    void AddRow(uint32_t key, int row);
+    void RemoveRow(uint32_t key, int row);
+};
+
+} // namespace gird
@@ -1,5 +1,60 @@
 // BuildFinancialColumns.h - Set up 200 financial columns with proper types
 
+// Display format of column i (numbers print through it, aggregates included)
+inline gird::NumberFormat FinancialNumberFormat(int i)
+{
+    using Notation = gird::NumberFormat::Notation;
+    using Unit = gird::NumberFormat::Unit;
+    const int generic = i >= 87 ? (i - 87) % 15 : -1;  // Data_Col_ layout, as generated
+
+    if (i == 11 || i == 29 || i == 30 || (i >= 37 && i <= 39) || i == 41 || generic == 1 || generic == 7) {
+        return {0, true};                                   // Quantities, volumes, market cap
+    } else if (i == 12 || i == 13 || i == 64 || i == 65 || i == 77 || i == 78 || i == 81 || i == 82 ||
+               (i >= 84 && i <= 86)) {
+        return {2, true};                                   // Notionals, P&L, exposures, margins
+    } else if (i == 14 || i == 15 || i == 18 || i == 31 || i == 33 || i == 34 || i == 42) {
+        return {2, false, Notation::Fixed, Unit::Percent};  // Held in percent already
+    } else if (i == 35) {
+        return {1, false, Notation::Fixed, Unit::Bps};
+    } else if ((i >= 47 && i <= 76) || i == 83 || generic == 10 || generic == 12 || generic == 14) {
+        return {4, false, Notation::Auto};                  // Greeks: scientific when tiny
+    } else if (i == 79 || i == 80 || generic == 2) {
+        return {4};                                         // Vols, correlations
+    }
+    return {};
+}
+
+// Conditional styles of column i: P&L red / green, heatmaps on the first-generation Greeks
+inline std::vector<gird::StyleRule> FinancialStyleRules(int i)
+{
+    using Kind = gird::StyleRule::Kind;
+    using gird::PackColor;
+    const uint32_t loss = PackColor(230, 95, 95), gain = PackColor(95, 200, 120);
+    const uint32_t cold = PackColor(60, 110, 220, 150), hot = PackColor(220, 80, 60, 150);
+    auto clear = [](uint32_t c) { return c & ~PackColor(0, 0, 0, 255); };  // same colour, alpha 0
+
+    // Shading grows from nothing at `zero` towards [lo, hi]
+    auto heat = [&](double lo, double zero, double hi) {
+        std::vector<gird::StyleRule> rules;
+        if (lo < zero)
+            rules.push_back({Kind::Gradient, lo, zero, 0, 0, cold, clear(cold)});
+        if (hi > zero)
+            rules.push_back({Kind::Gradient, zero, hi, 0, 0, clear(hot), hot});
+        return rules;
+    };
+
+    switch (i) {
+    case 13: case 14: case 18:  // MTM P&L, MTM Return %, Unrealized P&L %
+        return {{Kind::Below, 0.0, 0.0, 0, loss}, {Kind::Above, 0.0, 0.0, 0, gain}};
+    case 47: return heat(-1.0, 0.0, 1.0);      // Delta
+    case 48: return heat(0.0, 0.0, 0.1);       // Gamma
+    case 49: return heat(-1.0, 0.0, 0.0);      // Theta
+    case 50: return heat(0.0, 0.0, 50.0);      // Vega
+    case 51: return heat(-100.0, 0.0, 100.0);  // Rho
+    default: return {};
+    }
+}
+
 void BuildFinancialColumns(gird::GridDocument &doc)
 {
     std::vector<std::string> col_names = {
@@ -56,24 +111,28 @@ void BuildFinancialColumns(gird::GridDocument &doc)
         col.groupable = (i < 10);  // First 10 columns are groupable
 
 
-        // Determine type based on column
-        if (i == 0 || i == 1 || i == 2 || i == 3 || i == 4) {
-            col.type = gird::ValueType::String;  // Trader, Book, Account, Region, Desk
-        } else if (i == 8 || i == 9) {
-            col.type = gird::ValueType::String;  // Direction, Status
-        } else if (i == 10 || i == 25 || i == 35 || i == 45) {
-            col.type = gird::ValueType::String;  // Trade Date, Expiry Date, Maturity Date, Sector
-        } else if (i == 20 || i == 22 || i == 23) {
-            col.type = gird::ValueType::String;  // ISIN, Currency, Instrument Type
-        } else if (i == 24) {
-            col.type = gird::ValueType::String;  // Option Type
-        } else if (i == 5 || i == 6 || i == 7 || i == 11 || i == 12 || i == 29 || i == 30 || i == 31 || i == 32 || i == 45) {
-            col.type = gird::ValueType::Int64;  // Integer columns (IDs, quantities, volumes)
+        // Determine type based on column (must match FinancialDataGenerator's cells)
+        if (i == 10 || i == 25 || i == 32) {
+            col.type = gird::ValueType::Date;    // Trade Date, Expiry Date, Maturity Date
+        } else if (i <= 4 || i == 8 || i == 9) {
+            col.type = gird::ValueType::String;  // Trader, Book, Account, Region, Desk, Direction, Status
+        } else if (i == 19 || i == 20 || i == 21 || i == 22 || i == 23 || i == 26 || i == 45) {
+            col.type = gird::ValueType::String;  // Symbol, ISIN, Currency, Instrument/Option Type, Exchange, Sector
+        } else if (i == 5 || i == 6 || i == 7 || i == 11 || i == 29 || i == 30 || (i >= 37 && i <= 39) ||
+                   i == 42 || (i >= 87 && (i - 87) % 15 == 1)) {
+            col.type = gird::ValueType::Int64;   // Integer columns (IDs, quantities, volumes)
         } else {
             col.type = gird::ValueType::Double;  // Default to double for all numerical data
         }
 
-        col.getGroupKey = [i](const gird::SimpleRow &row) -> std::string {
+        col.number = FinancialNumberFormat(i);
+        col.styleRules = FinancialStyleRules(i);
+
+        // Labels print two decimals, like the groupBucket of 0.01 they key on
+        gird::NumberFormat number = col.number;
+        number.precision = 2;
+        number.notation = gird::NumberFormat::Notation::Fixed;
+        col.getGroupKey = [i, number](const gird::SimpleRow &row) -> std::string {
             if (i < 0 || i >= (int)row.size()) {
                 return "";
             }
@@ -81,31 +140,19 @@ void BuildFinancialColumns(gird::GridDocument &doc)
             if (std::holds_alternative<std::string>(cell)) {
                 return std::get<std::string>(cell);
             } else if (std::holds_alternative<int64_t>(cell)) {
-                return std::to_string(std::get<int64_t>(cell));
+                return gird::IntegerText(std::get<int64_t>(cell), number);
             } else if (std::holds_alternative<double>(cell)) {
-                char buf[64];
-                snprintf(buf, sizeof(buf), "%.2f", std::get<double>(cell));
-                return std::string(buf);
+                return gird::NumberText(std::get<double>(cell), number);
             }
             return "";
         };
+        col.typedGroupKey = true; // the key above just prints the value
 
         col.getValue = [i](const gird::SimpleRow &row) -> gird::Value {
             if (i < 0 || i >= (int)row.size()) {
                 return gird::Value(std::string(""));
             }
-            const auto& cell = row[i];
-
-            // Convert variant to string for display
-            if (std::holds_alternative<std::string>(cell)) {
-                return gird::Value(std::get<std::string>(cell));
-            } else if (std::holds_alternative<int64_t>(cell)) {
-                return gird::Value(std::to_string(std::get<int64_t>(cell)));
-            } else if (std::holds_alternative<double>(cell)) {
-                char buf[64];
-                snprintf(buf, sizeof(buf), "%.2f", std::get<double>(cell));
-                return gird::Value(std::string(buf));
-            }  // Return the cell directly
+            return row[i];  // Return the cell directly (typed)
         };
 
         doc.columns.push_back(col);
@@ -0,0 +1,222 @@
+#include "CellCache.h"
+
+#include <algorithm>
+
+namespace gird
+{
+
+namespace
+{
+
+// Arena slack tolerated before it is compacted
+constexpr size_t CompactSlackBytes = 64 << 10;
+
+} // namespace
+
+std::string_view PlainCell(const ColumnDef &col, const Value &v, char *buf)
+{
+    if (auto p = std::get_if<std::string>(&v))
+        return *p;
+    if (auto p = std::get_if<int64_t>(&v))
+        return {buf, FormatInteger(*p, col.number, buf)};
+    if (auto p = std::get_if<double>(&v))
+        return {buf, FormatNumber(*p, col.number, buf)};
+    if (auto p = std::get_if<bool>(&v))
+        return *p ? "true" : "false";
+    return {};
+}
+
+void ApplyStyleRules(const std::vector<StyleRule> &rules, double v, uint32_t &bg, uint32_t &text)
+{
+    for (const StyleRule &rule : rules)
+        switch (rule.kind)
+        {
+        case StyleRule::Kind::Below:
+        case StyleRule::Kind::Above:
+            if (rule.kind == StyleRule::Kind::Below ? v < rule.from : v > rule.from)
+            {
+                if (rule.bg)
+                    bg = rule.bg;
+                if (rule.text)
+                    text = rule.text;
+            }
+            break;
+        case StyleRule::Kind::Gradient:
+        {
+            if (!(v >= rule.from && v <= rule.to))
+                break;
+            const double t = rule.to > rule.from ? (v - rule.from) / (rule.to - rule.from) : 1.0;
+            uint32_t mixed = 0;
+            for (int shift = 0; shift < 32; shift += 8) // each 8-bit channel
+            {
+                const double lo = (rule.lowBg >> shift) & 0xFF;
+                const double hi = (rule.highBg >> shift) & 0xFF;
+                mixed |= static_cast<uint32_t>(lo + (hi - lo) * t + 0.5) << shift;
+            }
+            bg = mixed;
+            break;
+        }
+        }
+}
+
+std::string FormatCell(const ColumnDef &col, const Value &v)
+{
+    if (col.format)
+        return col.format(v);
+    char buf[MaxNumberChars];
+    return std::string(PlainCell(col, v, buf));
+}
+
+void CellTextCache::BeginFrame(const GridDocument &d)
+{
+    ++frame;
+
+    const int n = d.source ? d.source->RowCount() : 0;
+    const uint64_t version = d.source ? d.source->Version() : 0;
+    if (doc != &d || source != d.source || rowCount != n || columnCount != d.columns.size())
+    {
+        Clear();
+        doc = &d;
+        source = d.source;
+        rowCount = n;
+        columnCount = d.columns.size();
+        sourceVersion = version;
+    }
+    else if (version != sourceVersion)
+    {
+        std::vector<int> changed;
+        if (source->ChangedRowsSince(sourceVersion, changed))
+            for (int r : changed)
+                Erase(r);
+        else
+            Clear();
+        sourceVersion = version;
+    }
+
+    if (rows.size() > MaxRows)
+        for (auto it = rows.begin(); it != rows.end();)
+        {
+            if (it->second.frame + 1 < frame)
+            {
+                Release(it->second);
+                it = rows.erase(it);
+            }
+            else
+                ++it;
+        }
+
+    if (arena.size() > 2 * liveBytes + CompactSlackBytes)
+        Compact();
+}
+
+CellTextCache::RowCells &CellTextCache::Row(int row)
+{
+    RowCells &cells = rows[row];
+    if (cells.cols.empty())
+        cells.cols.resize(columnCount);
+    cells.frame = frame;
+    return cells;
+}
+
+void CellTextCache::Fill(const GridDocument &d, int row, int docCol, Span &span)
+{
+    const ColumnDef &col = d.columns[docCol];
+    const SimpleRow &src = d.source->RowAt(row);
+    const Value v = col.getValue ? col.getValue(src) : Value(std::string{});
+
+    // Without a custom format the text goes straight into the arena
+    char buf[MaxNumberChars];
+    std::string formatted;
+    const std::string_view text =
+        col.format ? std::string_view(formatted = col.format(v)) : PlainCell(col, v, buf);
+    span.offset = static_cast<uint32_t>(arena.size());
+    span.size = static_cast<uint32_t>(text.size());
+    arena.insert(arena.end(), text.begin(), text.end());
+    liveBytes += text.size();
+
+    span.bg = 0;
+    span.color = 0;
+    if (!col.styleRules.empty())
+    {
+        if (auto p = std::get_if<double>(&v))
+            ApplyStyleRules(col.styleRules, *p, span.bg, span.color);
+        else if (auto q = std::get_if<int64_t>(&v))
+            ApplyStyleRules(col.styleRules, static_cast<double>(*q), span.bg, span.color);
+    }
+    if (col.style)
+    {
+        const CellStyle style = col.style(src, v);
+        span.bg = style.bg_rgba.value_or(span.bg);
+        span.color = style.text_rgba.value_or(span.color);
+    }
+}
+
+void CellTextCache::Prepare(const GridDocument &d, const std::vector<int> &rowList,
+                            const std::vector<int> &docCols)
+{
+    std::vector<RowCells *> cells;
+    cells.reserve(rowList.size());
+    for (int row : rowList)
+        cells.push_back(&Row(row)); // unordered_map nodes stay put as rows are added
+
+    for (int docCol : docCols)
+        for (size_t i = 0; i < rowList.size(); ++i)
+            if (Span &span = cells[i]->cols[docCol]; span.size == Unset)
+                Fill(d, rowList[i], docCol, span);
+}
+
+CellTextCache::Cell CellTextCache::Get(const GridDocument &d, int row, int docCol)
+{
+    Span &span = Row(row).cols[docCol];
+    if (span.size == Unset)
+        Fill(d, row, docCol, span);
+    return {{arena.data() + span.offset, span.size}, span.bg, span.color};
+}
+
+void CellTextCache::Erase(int row)
+{
+    auto it = rows.find(row);
+    if (it == rows.end())
+        return;
+    Release(it->second);
+    rows.erase(it);
+}
+
+void CellTextCache::Release(const RowCells &cells)
+{
+    for (const Span &s : cells.cols)
+        if (s.size != Unset)
+            liveBytes -= s.size;
+}
+
+void CellTextCache::Compact()
+{
+    std::vector<char> packed;
+    packed.reserve(liveBytes);
+    for (auto &[row, cells] : rows)
+        for (Span &s : cells.cols)
+            if (s.size != Unset)
+            {
+                const uint32_t at = static_cast<uint32_t>(packed.size());
+                packed.insert(packed.end(), arena.begin() + s.offset, arena.begin() + s.offset + s.size);
+                s.offset = at;
+            }
+    arena.swap(packed);
+}
+
+void CellTextCache::Clear()
+{
+    rows.clear();
+    arena.clear();
+    liveBytes = 0;
+}
+
+size_t CellTextCache::MemoryBytes() const
+{
+    size_t bytes = arena.capacity();
+    for (const auto &[row, cells] : rows)
+        bytes += sizeof(RowCells) + cells.cols.capacity() * sizeof(Span);
+    return bytes;
+}
+
+} // namespace gird
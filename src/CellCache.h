@@ -0,0 +1,91 @@
+#pragma once
+#include "GridFramework.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace gird
+{
+
+// Display text of a value: the column's format, else PlainCell.
+[[nodiscard]] std::string FormatCell(const ColumnDef &col, const Value &v);
+// Text of a value without the column's format function: strings as they are,
+// numbers through the column's NumberFormat into `buf` (MaxNumberChars).
+[[nodiscard]] std::string_view PlainCell(const ColumnDef &col, const Value &v, char *buf);
+// Colours of a number under StyleRules (later matches win); unset ones untouched.
+void ApplyStyleRules(const std::vector<StyleRule> &rules, double v, uint32_t &bg, uint32_t &text);
+
+// ---- Formatted cell text of the rows on screen ----
+// Cells are formatted (getValue + format / NumberFormat) and styled
+// (ColumnDef::styleRules, then style) on first display and then served from
+// here until their row changes, so a steady frame formats and styles nothing.
+// Texts live back to back in one arena; each cached row keeps an (offset,
+// size, colours) per doc column, filled as its columns are drawn.
+//
+// Rows updated in place are dropped on the next frame (IRowSource::Version /
+// ChangedRowsSince, as for ColumnStore); a new source, row count or column
+// set drops everything. Past MaxRows, rows not shown on the last frame go, so
+// the cache holds the visible window plus what scrolled by recently.
+class CellTextCache
+{
+  public:
+    static constexpr size_t MaxRows = 1024;
+
+    struct Cell
+    {
+        std::string_view text;
+        uint32_t bg = 0;    // packed ImU32; 0 = none
+        uint32_t color = 0; // text colour; 0 = default
+    };
+
+    // Once per frame, before Prepare / Get.
+    void BeginFrame(const GridDocument &doc);
+    // Fills the missing cells of `rows` x `docCols` (the window on screen) a
+    // column at a time, so one column's rules and format stay hot.
+    void Prepare(const GridDocument &doc, const std::vector<int> &rows, const std::vector<int> &docCols);
+    // Cell of doc column `docCol` at source row `row` (filled now if missing);
+    // the text is valid until the next Prepare, Get or BeginFrame.
+    [[nodiscard]] Cell Get(const GridDocument &doc, int row, int docCol);
+    void Clear();
+
+    [[nodiscard]] size_t MemoryBytes() const;
+
+  private:
+    static constexpr uint32_t Unset = UINT32_MAX;
+
+    struct Span
+    {
+        uint32_t offset = 0;
+        uint32_t size = Unset;
+        uint32_t bg = 0;
+        uint32_t color = 0;
+    };
+    struct RowCells
+    {
+        std::vector<Span> cols; // per doc column
+        uint64_t frame = 0;     // last frame it was drawn on
+    };
+
+    RowCells &Row(int row);
+    void Fill(const GridDocument &doc, int row, int docCol, Span &span);
+    void Erase(int row);
+    void Release(const RowCells &cells); // its texts become arena slack
+    void Compact();
+
+    std::unordered_map<int, RowCells> rows;
+    std::vector<char> arena;
+    size_t liveBytes = 0; // arena bytes still referenced by a span
+
+    // What the cached texts were formatted from
+    const GridDocument *doc = nullptr;
+    const IRowSource *source = nullptr;
+    int rowCount = 0;
+    size_t columnCount = 0;
+    uint64_t sourceVersion = 0;
+    uint64_t frame = 0;
+};
+
+} // namespace gird
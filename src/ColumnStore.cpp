@@ -0,0 +1,380 @@
+#include "ColumnStore.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace gird
+{
+
+bool ParseIsoDate(std::string_view s, int32_t &days)
+{
+    if (s.size() < 10 || s[4] != '-' || s[7] != '-')
+        return false;
+
+    auto num = [&](int from, int len, int &out) -> bool
+    {
+        out = 0;
+        for (int i = from; i < from + len; ++i)
+        {
+            if (s[i] < '0' || s[i] > '9')
+                return false;
+            out = out * 10 + (s[i] - '0');
+        }
+        return true;
+    };
+
+    int y = 0, m = 0, d = 0;
+    if (!num(0, 4, y) || !num(5, 2, m) || !num(8, 2, d) || m < 1 || m > 12 || d < 1 || d > 31)
+        return false;
+
+    // days_from_civil (proleptic Gregorian)
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const int yoe = y - era * 400;
+    const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    days = era * 146097 + doe - 719468;
+    return true;
+}
+
+namespace
+{
+
+void SetNull(TypedColumn &out, int rows, int r, bool isNull)
+{
+    if (isNull)
+    {
+        if (out.nullCount == 0)
+            out.nulls.Resize(rows, false);
+        if (!out.nulls.Test(r))
+        {
+            out.nulls.Set(r);
+            ++out.nullCount;
+        }
+    }
+    else if (out.nullCount > 0 && out.nulls.Test(r))
+    {
+        out.nulls.Reset(r);
+        --out.nullCount;
+    }
+}
+
+uint32_t Encode(TypedColumn &out, const std::string &s)
+{
+    auto [it, inserted] = out.dictIndex.try_emplace(s, static_cast<uint32_t>(out.dict.size()));
+    if (inserted)
+        out.dict.push_back(s);
+    return it->second;
+}
+
+// Reads one cell through getValue into the typed arrays (build and patch path).
+void LoadCell(const ColumnDef &def, const IRowSource &source, int rows, int r, TypedColumn &out)
+{
+    if (!def.getValue)
+    {
+        SetNull(out, rows, r, true);
+        return;
+    }
+
+    const Value v = def.getValue(source.RowAt(r));
+    bool isNull = false;
+    switch (def.type)
+    {
+    case ValueType::Int64:
+        if (auto p = std::get_if<int64_t>(&v))
+            out.i64[r] = *p;
+        else
+            isNull = true;
+        break;
+    case ValueType::Bool:
+        if (auto p = std::get_if<bool>(&v))
+            out.i64[r] = *p ? 1 : 0;
+        else
+            isNull = true;
+        break;
+    case ValueType::Double:
+        if (auto p = std::get_if<double>(&v))
+            out.f64[r] = *p;
+        else if (auto pi = std::get_if<int64_t>(&v))
+            out.f64[r] = static_cast<double>(*pi);
+        else
+            isNull = true;
+        break;
+    case ValueType::Date:
+    {
+        const auto *p = std::get_if<std::string>(&v);
+        if (p && ParseIsoDate(*p, out.days[r]))
+            out.codes[r] = Encode(out, *p);
+        else
+            isNull = true;
+        break;
+    }
+    case ValueType::String:
+    default:
+        out.codes[r] = Encode(out, ValueToString(v));
+        break;
+    }
+    SetNull(out, rows, r, isNull);
+}
+
+// A cell as stored (value bits and null flag), to tell whether a patch moved it
+struct StoredCell
+{
+    uint64_t bits = 0;
+    bool null = false;
+    bool operator==(const StoredCell &) const = default;
+};
+
+StoredCell ReadStored(const TypedColumn &c, int r)
+{
+    StoredCell cell;
+    cell.null = c.nullCount > 0 && c.nulls.Test(r);
+    switch (c.type)
+    {
+    case ValueType::Int64:
+    case ValueType::Bool:
+        cell.bits = static_cast<uint64_t>(c.i64[r]);
+        break;
+    case ValueType::Double:
+        cell.bits = std::bit_cast<uint64_t>(c.f64[r]);
+        break;
+    case ValueType::Date: // the code names the text the day number came from
+    case ValueType::String:
+    default:
+        cell.bits = c.codes[r];
+        break;
+    }
+    return cell;
+}
+
+bool HasZones(ValueType t)
+{
+    return t != ValueType::String;
+}
+
+// Recomputes min/max/null count of one block from the typed arrays.
+void BuildZone(TypedColumn &c, int rows, int block)
+{
+    ZoneMap &z = c.zones;
+    const int begin = block * ZoneMap::BlockRows;
+    const int end = std::min(rows, begin + ZoneMap::BlockRows);
+
+    int nulls = 0;
+    if (c.type == ValueType::Double)
+    {
+        double lo = std::numeric_limits<double>::infinity();
+        double hi = -lo;
+        bool nan = false;
+        for (int r = begin; r < end; ++r)
+        {
+            if (c.nullCount > 0 && c.nulls.Test(r))
+            {
+                ++nulls;
+                continue;
+            }
+            const double x = c.f64[r];
+            nan |= std::isnan(x);
+            lo = std::min(lo, x);
+            hi = std::max(hi, x);
+        }
+        if (nan)
+            lo = hi = std::numeric_limits<double>::quiet_NaN();
+        z.minF[block] = lo;
+        z.maxF[block] = hi;
+    }
+    else
+    {
+        int64_t lo = std::numeric_limits<int64_t>::max();
+        int64_t hi = std::numeric_limits<int64_t>::min();
+        for (int r = begin; r < end; ++r)
+        {
+            if (c.nullCount > 0 && c.nulls.Test(r))
+            {
+                ++nulls;
+                continue;
+            }
+            const int64_t x = (c.type == ValueType::Date) ? c.days[r] : c.i64[r];
+            lo = std::min(lo, x);
+            hi = std::max(hi, x);
+        }
+        z.minI[block] = lo;
+        z.maxI[block] = hi;
+    }
+    z.nullCount[block] = nulls;
+}
+
+void BuildZones(TypedColumn &c, int rows)
+{
+    const int blocks = (rows + ZoneMap::BlockRows - 1) / ZoneMap::BlockRows;
+    ZoneMap &z = c.zones;
+    z.nullCount.assign(blocks, 0);
+    if (c.type == ValueType::Double)
+    {
+        z.minF.assign(blocks, 0.0);
+        z.maxF.assign(blocks, 0.0);
+    }
+    else
+    {
+        z.minI.assign(blocks, 0);
+        z.maxI.assign(blocks, 0);
+    }
+    for (int b = 0; b < blocks; ++b)
+        BuildZone(c, rows, b);
+}
+
+} // namespace
+
+bool ColumnStore::Current(const GridDocument &d) const
+{
+    const int n = d.source ? d.source->RowCount() : 0;
+    const uint64_t version = d.source ? d.source->Version() : 0;
+    return doc == &d && source == d.source && rowCount == n &&
+           columnCount == d.columns.size() && version == sourceVersion;
+}
+
+void ColumnStore::Sync(const GridDocument &d)
+{
+    if (Current(d))
+        return;
+
+    const int n = d.source ? d.source->RowCount() : 0;
+    const uint64_t version = d.source ? d.source->Version() : 0;
+    if (doc == &d && source == d.source && rowCount == n && columnCount == d.columns.size())
+    {
+        std::vector<int> changed;
+        if (source->ChangedRowsSince(sourceVersion, changed))
+        {
+            sourceVersion = version;
+            ++generation;
+            Patch(changed);
+            return;
+        }
+    }
+
+    doc = &d;
+    source = d.source;
+    rowCount = n;
+    columnCount = d.columns.size();
+    sourceVersion = version;
+    ++generation;
+    columnGenerations.assign(columnCount, generation);
+    columns.clear();
+    columns.resize(columnCount);
+    indexes.clear();
+    indexes.resize(columnCount);
+}
+
+uint64_t ColumnStore::Generation(const std::vector<int> &docCols) const
+{
+    // Generations only grow, so the latest over the set moves with any member.
+    // A column past the current layout went away in a rebuild: changed now.
+    uint64_t latest = 0;
+    for (int c : docCols)
+        latest = std::max(latest, static_cast<size_t>(c) < columnGenerations.size()
+                                      ? columnGenerations[c]
+                                      : generation);
+    return latest;
+}
+
+const TypedColumn &ColumnStore::Column(int docCol)
+{
+    auto &slot = columns[docCol];
+    if (!slot)
+    {
+        slot = std::make_unique<TypedColumn>();
+        Build(doc->columns[docCol], *slot);
+    }
+    return *slot;
+}
+
+const BitmapIndex *ColumnStore::Index(int docCol)
+{
+    const ColumnDef &def = doc->columns[docCol];
+    if (!def.groupable || def.type == ValueType::Double)
+        return nullptr;
+
+    auto &slot = indexes[docCol];
+    if (!slot)
+    {
+        slot = std::make_unique<BitmapIndex>();
+        slot->Build(Column(docCol));
+    }
+    return slot.get();
+}
+
+void ColumnStore::Patch(const std::vector<int> &rows)
+{
+    for (size_t c = 0; c < columns.size(); ++c)
+    {
+        TypedColumn *col = columns[c].get();
+        if (!col)
+            continue;
+        BitmapIndex *index = indexes[c].get();
+
+        std::vector<int> blocks; // zone blocks holding a changed cell
+        for (int r : rows)
+        {
+            const StoredCell before = ReadStored(*col, r);
+            uint32_t oldKey = 0;
+            const bool hadKey = index && index->KeyOfRow(*col, r, oldKey);
+
+            LoadCell(doc->columns[c], *source, rowCount, r, *col);
+            if (ReadStored(*col, r) == before)
+                continue;
+            columnGenerations[c] = generation;
+            blocks.push_back(r / ZoneMap::BlockRows);
+
+            uint32_t newKey = 0;
+            const bool hasKey = index && index->KeyOfRow(*col, r, newKey);
+            if (hadKey && (!hasKey || newKey != oldKey))
+                index->RemoveRow(oldKey, r);
+            if (hasKey && (!hadKey || newKey != oldKey))
+                index->AddRow(newKey, r);
+        }
+
+        // Min/max can only be restored by rescanning, so redo each touched block once
+        if (HasZones(col->type))
+        {
+            std::sort(blocks.begin(), blocks.end());
+            blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+            for (int b : blocks)
+                BuildZone(*col, rowCount, b);
+        }
+    }
+}
+
+void ColumnStore::Build(const ColumnDef &def, TypedColumn &out) const
+{
+    const int n = rowCount;
+    out.type = def.type;
+
+    switch (def.type)
+    {
+    case ValueType::Int64:
+    case ValueType::Bool:
+        out.i64.assign(n, 0);
+        break;
+    case ValueType::Double:
+        out.f64.assign(n, 0.0);
+        break;
+    case ValueType::Date:
+        out.days.assign(n, 0);
+        out.codes.assign(n, 0);
+        break;
+    case ValueType::String:
+    default:
+        out.codes.assign(n, 0);
+        break;
+    }
+
+    for (int r = 0; r < n; ++r)
+        LoadCell(def, *source, n, r, out);
+
+    if (HasZones(out.type))
+        BuildZones(out, n);
+}
+
+} // namespace gird
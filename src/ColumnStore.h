@@ -0,0 +1,96 @@
+#pragma once
+#include "Bitmap.h"
+#include "BitmapIndex.h"
+#include "GridFramework.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace gird
+{
+
+// Parses "yyyy-mm-dd" into days since 1970-01-01.
+bool ParseIsoDate(std::string_view s, int32_t &days);
+
+// ---- Zone map: per-block statistics of a numeric or date column ----
+// Range filters compare a block's [min, max] with their bounds to skip the block
+// or accept it whole. Null cells are left out of min/max, so an all-null block
+// has min > max; a Double block holding NaN gets NaN bounds and is always scanned.
+struct ZoneMap
+{
+    static constexpr int BlockRows = 4096; // 64 bitmap words per block
+
+    std::vector<int64_t> minI, maxI; // Int64, Bool, Date (day numbers)
+    std::vector<double> minF, maxF;  // Double
+    std::vector<int> nullCount;      // per block
+
+    [[nodiscard]] int BlockCount() const { return static_cast<int>(nullCount.size()); }
+};
+
+// ---- One doc column materialized from the row source ----
+struct TypedColumn
+{
+    ValueType type = ValueType::String;
+
+    std::vector<int64_t> i64;      // Int64, Bool (0/1)
+    std::vector<double> f64;       // Double
+    std::vector<int32_t> days;     // Date: days since epoch
+    std::vector<uint32_t> codes;   // String, Date: dictionary code per row
+    std::vector<std::string> dict; // code -> text (append-only, codes stay stable)
+    std::unordered_map<std::string, uint32_t> dictIndex; // text -> code
+
+    Bitmap nulls; // set = cell missing or not of the column type; empty if nullCount == 0
+    int nullCount = 0;
+
+    ZoneMap zones; // Int64, Bool, Double, Date; empty for String
+};
+
+// ---- Columnar mirror of GridDocument::source ----
+// Each column is built on first use with one getValue pass, after which
+// filters and aggregates run over flat typed arrays instead of variants.
+// Groupable columns can also carry a bitmap index (one row set per value),
+// likewise built on first use.
+//
+// In-place row updates (IRowSource::Version / ChangedRowsSince) are patched
+// into built columns and indexes row by row, and only columns whose cells
+// actually changed take the new generation; everything is dropped when the
+// source, its row count or the column dictionary changes, or the source can
+// no longer say which rows moved.
+class ColumnStore
+{
+  public:
+    void Sync(const GridDocument &doc);
+    // True when Sync(doc) would change nothing (same source, shape and version).
+    [[nodiscard]] bool Current(const GridDocument &doc) const;
+
+    [[nodiscard]] int RowCount() const { return rowCount; }
+    // Bumped whenever column contents change (rebuild or patch); anything
+    // holding dictionary codes or per-code tables must be rebuilt.
+    [[nodiscard]] uint64_t Generation() const { return generation; }
+    // Generation at which any of `docCols` last changed. Patches that leave a
+    // column's cells as they were do not move it, so state derived from a few
+    // columns can outlive updates to the others.
+    [[nodiscard]] uint64_t Generation(const std::vector<int> &docCols) const;
+    const TypedColumn &Column(int docCol);
+    // Bitmap index of a groupable column; null for other columns.
+    const BitmapIndex *Index(int docCol);
+
+  private:
+    const GridDocument *doc = nullptr;
+    const IRowSource *source = nullptr;
+    int rowCount = 0;
+    size_t columnCount = 0;
+    uint64_t generation = 0;
+    uint64_t sourceVersion = 0;
+    std::vector<uint64_t> columnGenerations; // per column: generation of its last change
+    std::vector<std::unique_ptr<TypedColumn>> columns;
+    std::vector<std::unique_ptr<BitmapIndex>> indexes;
+
+    void Build(const ColumnDef &def, TypedColumn &out) const;
+    void Patch(const std::vector<int> &rows);
+};
+
+} // namespace gird
@@ -0,0 +1,110 @@
+#include "CustomAggregate.h"
+#include "GridFramework.h"
+
+#include <cmath>
+
+namespace gird
+{
+
+void CustomAggregator::Merge(CustomState &into, const CustomState &from) const
+{
+    for (int i = 0; i < 4; ++i)
+        into.acc[i] += from.acc[i];
+    into.n += from.n;
+}
+
+const CustomAggregator *FindCustomAggregate(const GridDocument &doc, const std::string &id)
+{
+    for (const auto &agg : doc.customAggs)
+        if (agg && agg->Id() == id)
+            return agg.get();
+    return nullptr;
+}
+
+namespace
+{
+
+// acc[0] = sum(v * w), acc[1] = sum(w)
+class WeightedAverage final : public CustomAggregator
+{
+  public:
+    WeightedAverage() : CustomAggregator("wavg", "Weighted avg", true) {}
+
+    void Update(const double *values, const double *weights, int count, CustomState &s) const override
+    {
+        double vw = 0.0, w = 0.0;
+        for (int i = 0; i < count; ++i)
+        {
+            vw += values[i] * weights[i];
+            w += weights[i];
+        }
+        s.acc[0] += vw;
+        s.acc[1] += w;
+        s.n += count;
+    }
+
+    [[nodiscard]] std::string Finalize(const CustomState &s, const NumberFormat &fmt) const override
+    {
+        return s.n == 0 || s.acc[1] == 0.0 ? std::string{} : NumberText(s.acc[0] / s.acc[1], fmt);
+    }
+};
+
+// acc[0] = sum(v * w)
+class WeightedSum final : public CustomAggregator
+{
+  public:
+    WeightedSum() : CustomAggregator("wsum", "Weighted sum", true) {}
+
+    void Update(const double *values, const double *weights, int count, CustomState &s) const override
+    {
+        double vw = 0.0;
+        for (int i = 0; i < count; ++i)
+            vw += values[i] * weights[i];
+        s.acc[0] += vw;
+        s.n += count;
+    }
+
+    [[nodiscard]] std::string Finalize(const CustomState &s, const NumberFormat &fmt) const override
+    {
+        // value x weight is not in the value's unit
+        NumberFormat product = fmt;
+        product.unit = NumberFormat::Unit::None;
+        return s.n == 0 ? std::string{} : NumberText(s.acc[0], product);
+    }
+};
+
+// acc[0] = sum(v), acc[1] = sum(|v|)
+class NetGross final : public CustomAggregator
+{
+  public:
+    NetGross() : CustomAggregator("netgross", "Net / gross", false) {}
+
+    void Update(const double *values, const double *, int count, CustomState &s) const override
+    {
+        double net = 0.0, gross = 0.0;
+        for (int i = 0; i < count; ++i)
+        {
+            net += values[i];
+            gross += std::fabs(values[i]);
+        }
+        s.acc[0] += net;
+        s.acc[1] += gross;
+        s.n += count;
+    }
+
+    [[nodiscard]] std::string Finalize(const CustomState &s, const NumberFormat &fmt) const override
+    {
+        return s.n == 0 ? std::string{} : NumberText(s.acc[0], fmt) + " / " + NumberText(s.acc[1], fmt);
+    }
+};
+
+} // namespace
+
+void RegisterBuiltinAggregates(GridDocument &doc)
+{
+    doc.customAggs.push_back(std::make_shared<WeightedAverage>());
+    doc.customAggs.push_back(std::make_shared<WeightedSum>());
+    doc.customAggs.push_back(std::make_shared<NetGross>());
+}
+
+} // namespace gird
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace gird
+{
+
+struct GridDocument;
+struct NumberFormat;
+
+// Running state of one custom aggregator over a set of rows. Aggregators give
+// the fields their own meaning; a state starts zeroed (the init step), and
+// n == 0 marks one that has seen no rows yet.
+struct CustomState
+{
+    double acc[4] = {};
+    int64_t n = 0;
+};
+
+// ---- Custom aggregate (AggType::Custom) ----
+// Batch interface: the engine gathers a block of rows into contiguous arrays
+// (values of AggDef::column_id, and of AggDef::weightColumnId for weighted
+// aggregators; rows where either is null are left out) and calls Update once
+// per block, so there is no virtual call per row. Partial states of disjoint
+// row sets are combined with Merge (group rollups, parallel slices), and
+// Finalize turns a state into the cell text, printing numbers in the value
+// column's format.
+class CustomAggregator
+{
+  public:
+    CustomAggregator(std::string id, std::string label, bool weighted)
+        : id(std::move(id)), label(std::move(label)), weighted(weighted)
+    {
+    }
+    virtual ~CustomAggregator() = default;
+
+    [[nodiscard]] const std::string &Id() const { return id; }
+    [[nodiscard]] const std::string &Label() const { return label; }
+    [[nodiscard]] bool Weighted() const { return weighted; }
+
+    // `weights` is null unless Weighted().
+    virtual void Update(const double *values, const double *weights, int count, CustomState &s) const = 0;
+    // Default: field-wise sum (every aggregator below is additive)
+    virtual void Merge(CustomState &into, const CustomState &from) const;
+    [[nodiscard]] virtual std::string Finalize(const CustomState &s, const NumberFormat &fmt) const = 0;
+
+  private:
+    std::string id;
+    std::string label;
+    bool weighted = false;
+};
+
+// Registered aggregator with this id, or null.
+[[nodiscard]] const CustomAggregator *FindCustomAggregate(const GridDocument &doc,
+                                                          const std::string &id);
+
+// Adds the stock aggregators to doc.customAggs:
+//   wavg      weighted average, sum(v * w) / sum(w) (e.g. notional-weighted price)
+//   wsum      weighted sum, sum(v * w) (e.g. Greek times position size)
+//   netgross  net and gross exposure, sum(v) and sum(|v|)
+void RegisterBuiltinAggregates(GridDocument &doc);
+
+} // namespace gird
@@ -0,0 +1,556 @@
+#include "Filter.h"
+#include "ColumnStore.h"
+#include "FilterExpr.h"
+#include "TrigramIndex.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <string_view>
+
+namespace gird
+{
+
+namespace
+{
+
+bool ParseNumber(const std::string &s, double &out)
+{
+    if (s.empty())
+        return false;
+    char *end = nullptr;
+    out = std::strtod(s.c_str(), &end);
+    return end != s.c_str();
+}
+
+// Parses a bound/member against the column type (dates -> day number,
+// "true"/"false" for bools, everything else numeric).
+bool ParseTyped(ValueType type, const std::string &s, double &out)
+{
+    if (type == ValueType::Date)
+    {
+        int32_t d = 0;
+        if (!ParseIsoDate(s, d))
+            return false;
+        out = d;
+        return true;
+    }
+    if (type == ValueType::Bool && (s == "true" || s == "false"))
+    {
+        out = (s == "true") ? 1.0 : 0.0;
+        return true;
+    }
+    return ParseNumber(s, out);
+}
+
+// Parses an In member for an Int64/Bool column exactly; a member that is not a
+// whole integer ("1.5", "2e3", overflow) cannot equal any value and is dropped.
+bool ParseInteger(ValueType type, const std::string &s, int64_t &out)
+{
+    if (type == ValueType::Bool && (s == "true" || s == "false"))
+    {
+        out = (s == "true");
+        return true;
+    }
+    const char *last = s.data() + s.size();
+    const auto [end, ec] = std::from_chars(s.data(), last, out);
+    return ec == std::errc{} && end == last;
+}
+
+bool ParseRange(ValueType type, const ColumnFilter &f, double &lo, double &hi)
+{
+    lo = -std::numeric_limits<double>::infinity();
+    hi = std::numeric_limits<double>::infinity();
+    if (!f.lo.empty() && !ParseTyped(type, f.lo, lo))
+        return false;
+    if (!f.hi.empty() && !ParseTyped(type, f.hi, hi))
+        return false;
+    return true;
+}
+
+int64_t ClampToI64(double v)
+{
+    if (v <= static_cast<double>(std::numeric_limits<int64_t>::min()))
+        return std::numeric_limits<int64_t>::min();
+    if (v >= static_cast<double>(std::numeric_limits<int64_t>::max()))
+        return std::numeric_limits<int64_t>::max();
+    return static_cast<int64_t>(v);
+}
+
+// Fills bitmap words [w0, w1) with `pred` over v (n rows). `pred` is a lambda,
+// so it inlines into the word loop; 64 results are packed per store. With a
+// `mask` (refining a previous result) only the masked rows are tested, so the
+// cost follows the survivors.
+template <class T, class Pred>
+void FillWords(const T *v, int n, size_t w0, size_t w1, uint64_t *words, Pred pred,
+               const Bitmap *mask)
+{
+    for (size_t w = w0; w < w1; ++w)
+    {
+        const T *p = v + (w << 6);
+        uint64_t bits = 0;
+        if (mask)
+        {
+            for (uint64_t m = mask->words[w]; m; m &= m - 1)
+            {
+                const int b = std::countr_zero(m);
+                bits |= static_cast<uint64_t>(pred(p[b])) << b;
+            }
+        }
+        else
+        {
+            const int lim = std::min(64, n - static_cast<int>(w << 6));
+            for (int b = 0; b < lim; ++b)
+                bits |= static_cast<uint64_t>(pred(p[b])) << b;
+        }
+        words[w] = bits;
+    }
+}
+
+// One predicate -> one pass over the whole column.
+template <class T, class Pred>
+void FillBits(const T *v, int n, Bitmap &out, Pred pred, const Bitmap *mask)
+{
+    out.Resize(n, false);
+    FillWords(v, n, 0, out.words.size(), out.words.data(), pred, mask);
+}
+
+// Range predicate over a zone-mapped column. `zone(block)` says whether a
+// block can be skipped (< 0), accepted whole (> 0) or must be scanned (0);
+// only straddling blocks run the per-row loop. Null rows of accepted blocks
+// are cleared by the caller like any other predicate's.
+template <class T, class Pred, class Zone>
+void FillBitsZoned(const T *v, int n, int blocks, Bitmap &out, Pred pred, Zone zone,
+                   const Bitmap *mask, FilterStats *stats)
+{
+    constexpr size_t kBlockWords = ZoneMap::BlockRows / 64;
+    out.Resize(n, false);
+    uint64_t *words = out.words.data();
+    for (int b = 0; b < blocks; ++b)
+    {
+        const size_t w0 = b * kBlockWords;
+        const size_t w1 = std::min(w0 + kBlockWords, out.words.size());
+        const int z = zone(b);
+        if (z < 0)
+        {
+            if (stats)
+                ++stats->skipped;
+        }
+        else if (z > 0)
+        {
+            for (size_t w = w0; w < w1; ++w)
+                words[w] = mask ? mask->words[w] : ~uint64_t(0);
+            if (stats)
+                ++stats->accepted;
+        }
+        else
+            FillWords(v, n, w0, w1, words, pred, mask);
+    }
+    if (stats)
+        stats->blocks += blocks;
+    out.ClearTail();
+}
+
+// Zone test for a [lo, hi] range against one block's [min, max].
+template <class T> int ZoneTest(T min, T max, T lo, T hi)
+{
+    if (max < lo || min > hi)
+        return -1;
+    return (min >= lo && max <= hi) ? 1 : 0;
+}
+
+// Truth table over the dictionary: text predicates run once per distinct value,
+// the per-row loop is a table lookup on the code.
+template <class Pred> std::vector<uint8_t> DictTable(const TypedColumn &c, Pred pred)
+{
+    std::vector<uint8_t> t(c.dict.size());
+    for (size_t i = 0; i < c.dict.size(); ++i)
+        t[i] = pred(c.dict[i]) ? 1 : 0;
+    return t;
+}
+
+void FillFromTable(const TypedColumn &c, const std::vector<uint8_t> &table, int n, Bitmap &out,
+                   const Bitmap *mask)
+{
+    const uint8_t *t = table.data();
+    FillBits(c.codes.data(), n, out, [t](uint32_t code) { return t[code] != 0; }, mask);
+}
+
+template <class T> bool InSorted(const std::vector<T> &set, T x)
+{
+    if (set.size() <= 8)
+        return std::find(set.begin(), set.end(), x) != set.end();
+    return std::binary_search(set.begin(), set.end(), x);
+}
+
+std::string ToLower(std::string_view s)
+{
+    std::string out(s);
+    for (auto &ch : out)
+        ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    return out;
+}
+
+bool ContainsNoCase(std::string_view hay, const std::string &lowerNeedle)
+{
+    auto it = std::search(hay.begin(), hay.end(), lowerNeedle.begin(), lowerNeedle.end(),
+                          [](char a, char b)
+                          { return std::tolower(static_cast<unsigned char>(a)) == b; });
+    return it != hay.end();
+}
+
+bool EvaluateRange(const TypedColumn &c, const ColumnFilter &f, int n, Bitmap &out,
+                   const Bitmap *mask, FilterStats *stats)
+{
+    if (c.type == ValueType::String)
+    {
+        const auto table = DictTable(c,
+                                     [&](const std::string &s)
+                                     {
+                                         return (f.lo.empty() || s >= f.lo) &&
+                                                (f.hi.empty() || s <= f.hi);
+                                     });
+        FillFromTable(c, table, n, out, mask);
+        return true;
+    }
+
+    double lo = 0, hi = 0;
+    if (!ParseRange(c.type, f, lo, hi))
+        return false;
+
+    const ZoneMap &z = c.zones;
+
+    switch (c.type)
+    {
+    case ValueType::Int64:
+    case ValueType::Bool:
+    {
+        const int64_t ilo = ClampToI64(std::ceil(lo));
+        const int64_t ihi = ClampToI64(std::floor(hi));
+        FillBitsZoned(
+            c.i64.data(), n, z.BlockCount(), out,
+            [=](int64_t x) { return (x >= ilo) & (x <= ihi); },
+            [&](int b) { return ZoneTest(z.minI[b], z.maxI[b], ilo, ihi); }, mask, stats);
+        return true;
+    }
+    case ValueType::Double:
+        FillBitsZoned(
+            c.f64.data(), n, z.BlockCount(), out,
+            [=](double x) { return (x >= lo) & (x <= hi); },
+            [&](int b) { return ZoneTest(z.minF[b], z.maxF[b], lo, hi); }, mask, stats);
+        return true;
+    case ValueType::Date:
+    {
+        const auto dlo = static_cast<int32_t>(std::max(lo, -2147483648.0));
+        const auto dhi = static_cast<int32_t>(std::min(hi, 2147483647.0));
+        FillBitsZoned(
+            c.days.data(), n, z.BlockCount(), out,
+            [=](int32_t x) { return (x >= dlo) & (x <= dhi); },
+            [&](int b) { return ZoneTest<int64_t>(z.minI[b], z.maxI[b], dlo, dhi); }, mask,
+            stats);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+bool EvaluateIn(const TypedColumn &c, const ColumnFilter &f, int n, Bitmap &out,
+                const Bitmap *mask)
+{
+    switch (c.type)
+    {
+    case ValueType::Int64:
+    case ValueType::Bool:
+    {
+        std::vector<int64_t> set;
+        for (const auto &s : f.values)
+            if (int64_t v = 0; ParseInteger(c.type, s, v))
+                set.push_back(v);
+        std::sort(set.begin(), set.end());
+        FillBits(c.i64.data(), n, out, [&](int64_t x) { return InSorted(set, x); }, mask);
+        return true;
+    }
+    case ValueType::Double:
+    {
+        std::vector<double> set;
+        for (const auto &s : f.values)
+            if (double d = 0; ParseNumber(s, d))
+                set.push_back(d);
+        std::sort(set.begin(), set.end());
+        FillBits(c.f64.data(), n, out, [&](double x) { return InSorted(set, x); }, mask);
+        return true;
+    }
+    case ValueType::String:
+    case ValueType::Date:
+    {
+        std::vector<std::string> set = f.values;
+        std::sort(set.begin(), set.end());
+        const auto table = DictTable(c, [&](const std::string &s)
+                                     { return std::binary_search(set.begin(), set.end(), s); });
+        FillFromTable(c, table, n, out, mask);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+bool SameFilter(const ColumnFilter &a, const ColumnFilter &b)
+{
+    return a.column_id == b.column_id && a.op == b.op && a.lo == b.lo && a.hi == b.hi &&
+           a.values == b.values;
+}
+
+// Does moving one range bound from `prev` to `next` keep the range inside the old
+// one? Empty = open. A bound that does not parse was ignored, so only an
+// unchanged one is safe.
+bool BoundTightens(ValueType type, const std::string &prev, const std::string &next, bool lower)
+{
+    if (prev == next || prev.empty())
+        return true;
+    if (next.empty())
+        return false;
+    if (type == ValueType::String)
+        return lower ? next >= prev : next <= prev;
+    double p = 0, q = 0;
+    if (!ParseTyped(type, prev, p) || !ParseTyped(type, next, q))
+        return false;
+    return lower ? q >= p : q <= p;
+}
+
+// Every row passing `next` also passes `prev`.
+bool ColumnFilterRefines(const GridDocument &doc, const ColumnFilter &prev,
+                         const ColumnFilter &next)
+{
+    if (prev.column_id != next.column_id || prev.op != next.op)
+        return false;
+    if (next.op == FilterOp::In)
+    {
+        for (const auto &v : next.values)
+            if (std::find(prev.values.begin(), prev.values.end(), v) == prev.values.end())
+                return false;
+        return true;
+    }
+    const int col = GridController::FindColumn(doc, next.column_id);
+    if (col < 0)
+        return true; // unknown column: skipped either way
+    const ValueType type = doc.columns[col].type;
+    return BoundTightens(type, prev.lo, next.lo, true) &&
+           BoundTightens(type, prev.hi, next.hi, false);
+}
+
+} // namespace
+
+bool FilterIsActive(const FilterState &f)
+{
+    return !f.quickText.empty() || !f.columns.empty() || !f.expression.empty();
+}
+
+bool EvaluateColumnFilter(const GridDocument &doc, ColumnStore &store, const ColumnFilter &f,
+                          Bitmap &out, const Bitmap *mask, FilterStats *stats)
+{
+    const int col = GridController::FindColumn(doc, f.column_id);
+    if (col < 0)
+        return false;
+
+    const TypedColumn &c = store.Column(col);
+    const int n = store.RowCount();
+
+    if (f.op == FilterOp::IsNull)
+    {
+        if (c.nullCount > 0)
+            out = c.nulls;
+        else
+            out.Resize(n, false);
+        if (mask)
+            out.And(*mask);
+        return true;
+    }
+
+    // Equality / IN on an indexed column: union of the members' row sets
+    if (f.op == FilterOp::In)
+    {
+        if (const BitmapIndex *index = store.Index(col))
+        {
+            out.Resize(n, false);
+            for (const auto &v : f.values)
+                if (uint32_t key = 0; index->KeyOfText(c, v, key))
+                    index->rowsByKey[key].OrInto(out);
+            if (mask)
+                out.And(*mask);
+            return true;
+        }
+    }
+
+    const bool ok = (f.op == FilterOp::Range) ? EvaluateRange(c, f, n, out, mask, stats)
+                                              : EvaluateIn(c, f, n, out, mask);
+    if (ok && c.nullCount > 0)
+        out.AndNot(c.nulls);
+    return ok;
+}
+
+void EvaluateQuickText(const GridDocument &doc, ColumnStore &store, const std::string &text,
+                       Bitmap &out, const Bitmap *mask, const TrigramIndex *index)
+{
+    const int n = store.RowCount();
+    out.Resize(n, false);
+
+    const std::string needle = ToLower(text);
+    Bitmap hits;
+    for (int col = 0; col < static_cast<int>(doc.columns.size()); ++col)
+    {
+        const ValueType t = doc.columns[col].type;
+        if (t != ValueType::String && t != ValueType::Date)
+            continue;
+
+        if (index && index->RowCount() == n && index->Search(col, needle, hits, mask))
+        {
+            out.Or(hits);
+            continue;
+        }
+
+        const TypedColumn &c = store.Column(col);
+        const auto table =
+            DictTable(c, [&](const std::string &s) { return ContainsNoCase(s, needle); });
+        FillFromTable(c, table, n, hits, mask);
+        if (c.nullCount > 0)
+            hits.AndNot(c.nulls);
+        out.Or(hits);
+    }
+}
+
+void EvaluateFilter(const GridDocument &doc, ColumnStore &store, const FilterInputs &in,
+                    Bitmap &out)
+{
+    EvaluateFilter(doc, store, doc.filter, in, out);
+}
+
+void EvaluateFilter(const GridDocument &doc, ColumnStore &store, const FilterState &f,
+                    const FilterInputs &in, Bitmap &out)
+{
+
+    bool have = false;
+    Bitmap tmp;
+    for (const auto &cf : f.columns)
+    {
+        if (!EvaluateColumnFilter(doc, store, cf, tmp, nullptr, in.stats))
+            continue;
+
+        if (!have)
+        {
+            std::swap(out, tmp);
+            have = true;
+        }
+        else if (f.combine == FilterCombine::All)
+            out.And(tmp);
+        else
+            out.Or(tmp);
+    }
+
+    if (!f.quickText.empty())
+    {
+        EvaluateQuickText(doc, store, f.quickText, tmp, nullptr, in.text);
+        if (!have)
+        {
+            std::swap(out, tmp);
+            have = true;
+        }
+        else
+            out.And(tmp);
+    }
+
+    if (in.expr)
+    {
+        in.expr->Evaluate(tmp);
+        if (!have)
+        {
+            std::swap(out, tmp);
+            have = true;
+        }
+        else
+            out.And(tmp);
+    }
+
+    if (!have)
+        out.Resize(store.RowCount(), true);
+}
+
+bool FilterRefines(const GridDocument &doc, const FilterState &prev, const FilterState &next)
+{
+    // Quick text: a match of the longer needle contains the shorter one
+    if (ToLower(next.quickText).find(ToLower(prev.quickText)) == std::string::npos)
+        return false;
+
+    // Expression: may appear (it ANDs in), but any edit to it is a rescan
+    if (!prev.expression.empty() && prev.expression != next.expression)
+        return false;
+
+    if (prev.columns.empty())
+        return true;
+    if (prev.combine != next.combine)
+        return false;
+
+    // All: predicates may be added; Any: adding one would widen the union
+    if (next.columns.size() < prev.columns.size() ||
+        (next.combine == FilterCombine::Any && next.columns.size() != prev.columns.size()))
+        return false;
+    for (size_t i = 0; i < prev.columns.size(); ++i)
+        if (!ColumnFilterRefines(doc, prev.columns[i], next.columns[i]))
+            return false;
+    return true;
+}
+
+void RefineFilter(const GridDocument &doc, ColumnStore &store, const FilterInputs &in,
+                  const FilterState &prev, Bitmap &selection)
+{
+    const FilterState &f = doc.filter;
+    Bitmap tmp;
+
+    // Every masked evaluation below returns a subset of `selection`, so each
+    // result simply replaces it.
+    if (f.combine == FilterCombine::All || f.columns.size() == 1)
+    {
+        for (size_t i = 0; i < f.columns.size(); ++i)
+        {
+            if (i < prev.columns.size() && SameFilter(prev.columns[i], f.columns[i]))
+                continue;
+            if (EvaluateColumnFilter(doc, store, f.columns[i], tmp, &selection, in.stats))
+                std::swap(selection, tmp);
+        }
+    }
+    else if (!std::equal(f.columns.begin(), f.columns.end(), prev.columns.begin(),
+                         prev.columns.end(), SameFilter))
+    {
+        // Any: a tightened member can still be covered by another, so the
+        // union is recomputed, but only over the survivors
+        bool have = false;
+        Bitmap any(selection.size, false);
+        for (const auto &cf : f.columns)
+            if (EvaluateColumnFilter(doc, store, cf, tmp, &selection, in.stats))
+            {
+                any.Or(tmp);
+                have = true;
+            }
+        if (have)
+            std::swap(selection, any);
+    }
+
+    if (f.quickText != prev.quickText)
+    {
+        EvaluateQuickText(doc, store, f.quickText, tmp, &selection, in.text);
+        std::swap(selection, tmp);
+    }
+
+    if (in.expr && f.expression != prev.expression)
+    {
+        in.expr->Evaluate(tmp, &selection);
+        std::swap(selection, tmp);
+    }
+}
+
+} // namespace gird
@@ -0,0 +1,55 @@
+#pragma once
+#include "Bitmap.h"
+#include "GridFramework.h"
+
+namespace gird
+{
+
+class TrigramIndex;
+
+// What a filter pass reads besides the document and the store.
+struct FilterInputs
+{
+    const FilterProgram *expr = nullptr; // doc.filter.expression compiled (null = none or invalid)
+    const TrigramIndex *text = nullptr;  // ready trigram index for quick text (null = scan)
+    FilterStats *stats = nullptr;        // zone-map counters (optional)
+};
+
+[[nodiscard]] bool FilterIsActive(const FilterState &f);
+
+// Evaluates one column predicate over the whole column into `out`, or only over
+// the rows set in `mask` (out is then a subset of it). Range predicates on
+// numeric/date columns consult the zone map and add their block counts to `stats`.
+// Returns false if the column is unknown or the predicate does not parse.
+bool EvaluateColumnFilter(const GridDocument &doc, ColumnStore &store, const ColumnFilter &f,
+                          Bitmap &out, const Bitmap *mask = nullptr,
+                          FilterStats *stats = nullptr);
+
+// Quick text: case-insensitive substring match over the String/Date columns.
+// Columns covered by `index` are answered from their trigram postings when the
+// text is 3+ characters; the rest run a dictionary truth table.
+void EvaluateQuickText(const GridDocument &doc, ColumnStore &store, const std::string &text,
+                       Bitmap &out, const Bitmap *mask = nullptr,
+                       const TrigramIndex *index = nullptr);
+
+// Evaluates doc.filter into `out` (bit set = row passes). Each predicate is one
+// typed loop over its column; results are combined word-parallel.
+void EvaluateFilter(const GridDocument &doc, ColumnStore &store, const FilterInputs &in,
+                    Bitmap &out);
+// The same over `filter` in place of doc.filter (in.expr, if set, must be its
+// compiled expression).
+void EvaluateFilter(const GridDocument &doc, ColumnStore &store, const FilterState &filter,
+                    const FilterInputs &in, Bitmap &out);
+
+// True if `next` can only drop rows that pass `prev`: the quick text extends
+// the old text, ranges tighten, IN sets shrink, or predicates are added (All).
+[[nodiscard]] bool FilterRefines(const GridDocument &doc, const FilterState &prev,
+                                 const FilterState &next);
+
+// Narrows `selection` (the result of `prev` on the same store generation) to
+// doc.filter, re-testing only the surviving rows against the predicates that
+// changed. Requires FilterRefines(doc, prev, doc.filter).
+void RefineFilter(const GridDocument &doc, ColumnStore &store, const FilterInputs &in,
+                  const FilterState &prev, Bitmap &selection);
+
+} // namespace gird
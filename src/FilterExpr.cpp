@@ -0,0 +1,1014 @@
+#include "FilterExpr.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+
+namespace gird
+{
+
+namespace
+{
+
+// ============================================================
+// Lexer
+// ============================================================
+
+enum class Tok
+{
+    End,
+    Number,
+    String, // 'literal'
+    Ident,  // bare or "quoted" / `quoted` identifier
+    LParen,
+    RParen,
+    Comma,
+    Op // + - * / < <= > >= = == != <> ! && ||
+};
+
+struct Token
+{
+    Tok kind = Tok::End;
+    std::string text;
+    double number = 0;
+    size_t pos = 0;
+};
+
+std::string Lower(std::string s)
+{
+    for (auto &c : s)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+bool Lex(const std::string &src, std::vector<Token> &out, std::string &error)
+{
+    size_t i = 0;
+    while (true)
+    {
+        while (i < src.size() && std::isspace(static_cast<unsigned char>(src[i])))
+            ++i;
+
+        Token t;
+        t.pos = i;
+        if (i >= src.size())
+        {
+            out.push_back(t);
+            return true;
+        }
+
+        const char c = src[i];
+        if (std::isdigit(static_cast<unsigned char>(c)) ||
+            (c == '.' && i + 1 < src.size() && std::isdigit(static_cast<unsigned char>(src[i + 1]))))
+        {
+            char *end = nullptr;
+            t.kind = Tok::Number;
+            t.number = std::strtod(src.c_str() + i, &end);
+            i = end - src.c_str();
+        }
+        else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_')
+        {
+            t.kind = Tok::Ident;
+            while (i < src.size() && (std::isalnum(static_cast<unsigned char>(src[i])) || src[i] == '_'))
+                t.text += src[i++];
+        }
+        else if (c == '\'' || c == '"' || c == '`')
+        {
+            t.kind = (c == '\'') ? Tok::String : Tok::Ident;
+            ++i;
+            while (true)
+            {
+                if (i >= src.size())
+                {
+                    error = "unterminated quote at " + std::to_string(t.pos);
+                    return false;
+                }
+                if (src[i] == c)
+                {
+                    if (c == '\'' && i + 1 < src.size() && src[i + 1] == '\'')
+                    {
+                        t.text += '\'';
+                        i += 2;
+                        continue;
+                    }
+                    ++i;
+                    break;
+                }
+                t.text += src[i++];
+            }
+        }
+        else if (c == '(' || c == ')' || c == ',')
+        {
+            t.kind = (c == '(') ? Tok::LParen : (c == ')') ? Tok::RParen : Tok::Comma;
+            t.text = c;
+            ++i;
+        }
+        else
+        {
+            static const char *ops[] = {"<=", ">=", "==", "!=", "<>", "&&", "||",
+                                        "<",  ">",  "=",  "!",  "+",  "-",  "*", "/"};
+            for (const char *op : ops)
+            {
+                const size_t len = std::char_traits<char>::length(op);
+                if (src.compare(i, len, op) == 0)
+                {
+                    t.kind = Tok::Op;
+                    t.text = op;
+                    i += len;
+                    break;
+                }
+            }
+            if (t.kind != Tok::Op)
+            {
+                error = std::string("unexpected '") + c + "' at " + std::to_string(i);
+                return false;
+            }
+        }
+        out.push_back(std::move(t));
+    }
+}
+
+// ============================================================
+// Parser -> AST
+// ============================================================
+
+struct Node
+{
+    enum class Kind
+    {
+        Number,
+        String,
+        Column,
+        Unary,  // text = "-" | "not"
+        Binary, // text = operator, "and", "or"
+        Call,   // text = function name
+        In      // kids[0] in (kids[1..]); negate = "not in"
+    } kind = Kind::Number;
+
+    std::string text;
+    double number = 0;
+    int column = -1;
+    bool negate = false;
+    std::vector<std::unique_ptr<Node>> kids;
+};
+
+using NodePtr = std::unique_ptr<Node>;
+
+int ResolveColumn(const GridDocument &doc, const std::string &name)
+{
+    const int n = static_cast<int>(doc.columns.size());
+    for (int c = 0; c < n; ++c)
+        if (doc.columns[c].id == name)
+            return c;
+
+    const std::string key = Lower(name);
+    for (int c = 0; c < n; ++c)
+        if (Lower(doc.columns[c].label) == key)
+            return c;
+
+    // Whole-word label prefix: "MTM" -> "MTM P&L"
+    for (int c = 0; c < n; ++c)
+    {
+        const std::string label = Lower(doc.columns[c].label);
+        if (label.size() > key.size() && label.compare(0, key.size(), key) == 0 &&
+            !std::isalnum(static_cast<unsigned char>(label[key.size()])))
+            return c;
+    }
+    return -1;
+}
+
+class Parser
+{
+  public:
+    Parser(const GridDocument &doc, std::vector<Token> toks) : doc(doc), toks(std::move(toks)) {}
+
+    NodePtr Parse(std::string &err)
+    {
+        NodePtr root = ParseOr();
+        if (root && Peek().kind != Tok::End)
+            Fail("unexpected '" + Peek().text + "'");
+        err = error;
+        return error.empty() ? std::move(root) : nullptr;
+    }
+
+  private:
+    const GridDocument &doc;
+    std::vector<Token> toks;
+    size_t at = 0;
+    std::string error;
+
+    const Token &Peek() const { return toks[at]; }
+    Token Next() { return toks[at < toks.size() - 1 ? at++ : at]; }
+
+    bool IsKeyword(const char *kw) const
+    {
+        return Peek().kind == Tok::Ident && Lower(Peek().text) == kw;
+    }
+    bool IsOp(const char *op) const { return Peek().kind == Tok::Op && Peek().text == op; }
+
+    NodePtr Fail(const std::string &msg)
+    {
+        if (error.empty())
+            error = msg + " at " + std::to_string(Peek().pos);
+        return nullptr;
+    }
+
+    static NodePtr Make(Node::Kind kind, std::string text, NodePtr a, NodePtr b = nullptr)
+    {
+        auto n = std::make_unique<Node>();
+        n->kind = kind;
+        n->text = std::move(text);
+        n->kids.push_back(std::move(a));
+        if (b)
+            n->kids.push_back(std::move(b));
+        return n;
+    }
+
+    NodePtr ParseOr()
+    {
+        NodePtr lhs = ParseAnd();
+        while (lhs && (IsKeyword("or") || IsOp("||")))
+        {
+            Next();
+            NodePtr rhs = ParseAnd();
+            if (!rhs)
+                return nullptr;
+            lhs = Make(Node::Kind::Binary, "or", std::move(lhs), std::move(rhs));
+        }
+        return lhs;
+    }
+
+    NodePtr ParseAnd()
+    {
+        NodePtr lhs = ParseNot();
+        while (lhs && (IsKeyword("and") || IsOp("&&")))
+        {
+            Next();
+            NodePtr rhs = ParseNot();
+            if (!rhs)
+                return nullptr;
+            lhs = Make(Node::Kind::Binary, "and", std::move(lhs), std::move(rhs));
+        }
+        return lhs;
+    }
+
+    NodePtr ParseNot()
+    {
+        if (IsKeyword("not") || IsOp("!"))
+        {
+            Next();
+            NodePtr inner = ParseNot();
+            return inner ? Make(Node::Kind::Unary, "not", std::move(inner)) : nullptr;
+        }
+        return ParseCompare();
+    }
+
+    NodePtr ParseCompare()
+    {
+        NodePtr lhs = ParseAdd();
+        if (!lhs)
+            return nullptr;
+
+        bool negate = false;
+        if (IsKeyword("not") && toks[at + 1].kind == Tok::Ident && Lower(toks[at + 1].text) == "in")
+        {
+            Next();
+            negate = true;
+        }
+        if (IsKeyword("in"))
+        {
+            Next();
+            if (Peek().kind != Tok::LParen)
+                return Fail("expected '(' after in");
+            Next();
+            auto n = Make(Node::Kind::In, "in", std::move(lhs));
+            n->negate = negate;
+            while (true)
+            {
+                NodePtr item = ParseUnary();
+                if (!item)
+                    return nullptr;
+                if (item->kind != Node::Kind::Number && item->kind != Node::Kind::String)
+                    return Fail("in (...) takes literals only");
+                n->kids.push_back(std::move(item));
+                if (Peek().kind == Tok::Comma)
+                {
+                    Next();
+                    continue;
+                }
+                if (Peek().kind != Tok::RParen)
+                    return Fail("expected ')'");
+                Next();
+                return n;
+            }
+        }
+        if (negate)
+            return Fail("expected in");
+
+        // Spelling -> canonical operator
+        static const char *cmps[][2] = {{"<", "<"},   {"<=", "<="}, {">", ">"},   {">=", ">="},
+                                        {"=", "="},   {"==", "="},  {"!=", "!="}, {"<>", "!="}};
+        for (const auto &[spelling, op] : cmps)
+        {
+            if (IsOp(spelling))
+            {
+                Next();
+                NodePtr rhs = ParseAdd();
+                return rhs ? Make(Node::Kind::Binary, op, std::move(lhs), std::move(rhs)) : nullptr;
+            }
+        }
+        return lhs;
+    }
+
+    NodePtr ParseAdd()
+    {
+        NodePtr lhs = ParseMul();
+        while (lhs && (IsOp("+") || IsOp("-")))
+        {
+            std::string op = Next().text;
+            NodePtr rhs = ParseMul();
+            if (!rhs)
+                return nullptr;
+            lhs = Make(Node::Kind::Binary, op, std::move(lhs), std::move(rhs));
+        }
+        return lhs;
+    }
+
+    NodePtr ParseMul()
+    {
+        NodePtr lhs = ParseUnary();
+        while (lhs && (IsOp("*") || IsOp("/")))
+        {
+            std::string op = Next().text;
+            NodePtr rhs = ParseUnary();
+            if (!rhs)
+                return nullptr;
+            lhs = Make(Node::Kind::Binary, op, std::move(lhs), std::move(rhs));
+        }
+        return lhs;
+    }
+
+    NodePtr ParseUnary()
+    {
+        if (IsOp("-"))
+        {
+            Next();
+            NodePtr inner = ParseUnary();
+            if (!inner)
+                return nullptr;
+            if (inner->kind == Node::Kind::Number)
+            {
+                inner->number = -inner->number;
+                return inner;
+            }
+            return Make(Node::Kind::Unary, "-", std::move(inner));
+        }
+        return ParsePrimary();
+    }
+
+    NodePtr ParsePrimary()
+    {
+        const Token t = Peek();
+        switch (t.kind)
+        {
+        case Tok::Number:
+        {
+            Next();
+            auto n = std::make_unique<Node>();
+            n->kind = Node::Kind::Number;
+            n->number = t.number;
+            return n;
+        }
+        case Tok::String:
+        {
+            Next();
+            auto n = std::make_unique<Node>();
+            n->kind = Node::Kind::String;
+            n->text = t.text;
+            return n;
+        }
+        case Tok::LParen:
+        {
+            Next();
+            NodePtr inner = ParseOr();
+            if (!inner)
+                return nullptr;
+            if (Peek().kind != Tok::RParen)
+                return Fail("expected ')'");
+            Next();
+            return inner;
+        }
+        case Tok::Ident:
+        {
+            Next();
+            if (Peek().kind == Tok::LParen)
+            {
+                const std::string fn = Lower(t.text);
+                if (fn != "abs" && fn != "min" && fn != "max")
+                    return Fail("unknown function '" + t.text + "'");
+                Next();
+                auto n = std::make_unique<Node>();
+                n->kind = Node::Kind::Call;
+                n->text = fn;
+                while (true)
+                {
+                    NodePtr arg = ParseOr();
+                    if (!arg)
+                        return nullptr;
+                    n->kids.push_back(std::move(arg));
+                    if (Peek().kind == Tok::Comma)
+                    {
+                        Next();
+                        continue;
+                    }
+                    if (Peek().kind != Tok::RParen)
+                        return Fail("expected ')'");
+                    Next();
+                    break;
+                }
+                const size_t want = (fn == "abs") ? 1 : 2;
+                if (n->kids.size() != want)
+                    return Fail(fn + "() takes " + std::to_string(want) + " argument(s)");
+                return n;
+            }
+
+            const int col = ResolveColumn(doc, t.text);
+            if (col < 0)
+            {
+                --at;
+                return Fail("unknown column '" + t.text + "'");
+            }
+            auto n = std::make_unique<Node>();
+            n->kind = Node::Kind::Column;
+            n->column = col;
+            n->text = t.text;
+            return n;
+        }
+        default:
+            return Fail(t.kind == Tok::End ? "unexpected end" : "unexpected '" + t.text + "'");
+        }
+    }
+};
+
+} // namespace
+
+// ============================================================
+// Compiler: AST -> register bytecode
+// ============================================================
+
+struct ExprCompiler
+{
+    const GridDocument &doc;
+    ColumnStore &store;
+    FilterProgram &prog;
+    std::string error;
+
+    enum class Type
+    {
+        Num,
+        Bool,
+        Text, // String/Date column not yet loaded (only valid in comparisons / in)
+        Lit   // string literal
+    };
+
+    struct Operand
+    {
+        Type type = Type::Num;
+        int reg = -1;
+        int column = -1;
+        const Node *node = nullptr;
+    };
+
+    using Op = FilterProgram::Op;
+
+    bool Fail(const std::string &msg)
+    {
+        if (error.empty())
+            error = msg;
+        return false;
+    }
+
+    int NewNum() { return prog.numRegs++; }
+    int NewBool() { return prog.boolRegs++; }
+
+    void Emit(Op op, int dst, int a = 0, int b = 0, int arg = -1, const TypedColumn *col = nullptr)
+    {
+        FilterProgram::Instr ins;
+        ins.op = op;
+        ins.dst = static_cast<uint16_t>(dst);
+        ins.a = static_cast<uint16_t>(a);
+        ins.b = static_cast<uint16_t>(b);
+        ins.arg = arg;
+        ins.col = col;
+        (op == Op::Const ? prog.prologue : prog.code).push_back(ins);
+    }
+
+    int Constant(double v)
+    {
+        const int reg = NewNum();
+        prog.constants.push_back(v);
+        Emit(Op::Const, reg, 0, 0, static_cast<int>(prog.constants.size()) - 1);
+        return reg;
+    }
+
+    ValueType ColType(int col) const { return doc.columns[col].type; }
+
+    // Loads a column operand as numbers (Date columns as day numbers).
+    bool ToNum(Operand &o)
+    {
+        if (o.type == Type::Num)
+            return true;
+        if (o.type == Type::Text && ColType(o.column) == ValueType::Date)
+        {
+            o.reg = NewNum();
+            Emit(Op::LoadDays, o.reg, 0, 0, -1, &store.Column(o.column));
+            o.type = Type::Num;
+            return true;
+        }
+        if (o.type == Type::Lit)
+            return Fail("string '" + o.node->text + "' used as a number");
+        if (o.type == Type::Text)
+            return Fail("text column '" + doc.columns[o.column].label + "' used as a number");
+        return Fail("condition used as a number");
+    }
+
+    bool Compile(const Node &n, Operand &out)
+    {
+        out = Operand{};
+        out.node = &n;
+        switch (n.kind)
+        {
+        case Node::Kind::Number:
+            out.type = Type::Num;
+            out.reg = Constant(n.number);
+            return true;
+
+        case Node::Kind::String:
+            out.type = Type::Lit;
+            return true;
+
+        case Node::Kind::Column:
+        {
+            const ValueType t = ColType(n.column);
+            out.column = n.column;
+            if (t == ValueType::String || t == ValueType::Date)
+            {
+                out.type = Type::Text;
+                return true;
+            }
+            out.type = Type::Num;
+            out.reg = NewNum();
+            Emit(t == ValueType::Double ? Op::LoadF64 : Op::LoadI64, out.reg, 0, 0, -1,
+                 &store.Column(n.column));
+            return true;
+        }
+
+        case Node::Kind::Unary:
+        {
+            Operand a;
+            if (!Compile(*n.kids[0], a))
+                return false;
+            if (n.text == "not")
+            {
+                if (a.type != Type::Bool)
+                    return Fail("'not' needs a condition");
+                out.type = Type::Bool;
+                out.reg = NewBool();
+                Emit(Op::Not, out.reg, a.reg);
+                return true;
+            }
+            if (!ToNum(a))
+                return false;
+            out.type = Type::Num;
+            out.reg = NewNum();
+            Emit(Op::Neg, out.reg, a.reg);
+            return true;
+        }
+
+        case Node::Kind::Call:
+        {
+            Operand a, b;
+            if (!Compile(*n.kids[0], a) || !ToNum(a))
+                return false;
+            out.type = Type::Num;
+            out.reg = NewNum();
+            if (n.text == "abs")
+            {
+                Emit(Op::Abs, out.reg, a.reg);
+                return true;
+            }
+            if (!Compile(*n.kids[1], b) || !ToNum(b))
+                return false;
+            Emit(n.text == "min" ? Op::Min : Op::Max, out.reg, a.reg, b.reg);
+            return true;
+        }
+
+        case Node::Kind::In:
+            return CompileIn(n, out);
+
+        case Node::Kind::Binary:
+            return CompileBinary(n, out);
+        }
+        return Fail("bad expression");
+    }
+
+    bool CompileBinary(const Node &n, Operand &out)
+    {
+        Operand a, b;
+        if (!Compile(*n.kids[0], a) || !Compile(*n.kids[1], b))
+            return false;
+
+        if (n.text == "and" || n.text == "or")
+        {
+            if (a.type != Type::Bool || b.type != Type::Bool)
+                return Fail("'" + n.text + "' needs conditions on both sides");
+            out.type = Type::Bool;
+            out.reg = NewBool();
+            Emit(n.text == "and" ? Op::And : Op::Or, out.reg, a.reg, b.reg);
+            return true;
+        }
+
+        static const struct
+        {
+            const char *text;
+            Op op;
+        } arith[] = {{"+", Op::Add}, {"-", Op::Sub}, {"*", Op::Mul}, {"/", Op::Div}};
+        for (const auto &e : arith)
+        {
+            if (n.text == e.text)
+            {
+                if (!ToNum(a) || !ToNum(b))
+                    return false;
+                out.type = Type::Num;
+                out.reg = NewNum();
+                Emit(e.op, out.reg, a.reg, b.reg);
+                return true;
+            }
+        }
+
+        // Comparison. Text column vs literal compiles to a dictionary table;
+        // put the column on the left so only one shape needs handling.
+        std::string op = n.text;
+        if (a.type == Type::Lit && b.type == Type::Text)
+        {
+            std::swap(a, b);
+            if (op[0] == '<')
+                op[0] = '>';
+            else if (op[0] == '>')
+                op[0] = '<';
+        }
+
+        if (a.type == Type::Text && b.type == Type::Lit)
+        {
+            if (ColType(a.column) == ValueType::Date)
+            {
+                int32_t day = 0;
+                if (!ParseIsoDate(b.node->text, day))
+                    return Fail("'" + b.node->text + "' is not a yyyy-mm-dd date");
+                b.type = Type::Num;
+                b.reg = Constant(day);
+            }
+            else
+            {
+                const TypedColumn &c = store.Column(a.column);
+                const std::string &lit = b.node->text;
+                std::vector<uint8_t> table(c.dict.size());
+                for (size_t i = 0; i < c.dict.size(); ++i)
+                {
+                    const int cmp = c.dict[i].compare(lit);
+                    bool v = false;
+                    if (op == "<")
+                        v = cmp < 0;
+                    else if (op == "<=")
+                        v = cmp <= 0;
+                    else if (op == ">")
+                        v = cmp > 0;
+                    else if (op == ">=")
+                        v = cmp >= 0;
+                    else if (op == "=")
+                        v = cmp == 0;
+                    else
+                        v = cmp != 0;
+                    table[i] = v ? 1 : 0;
+                }
+                prog.tables.push_back(std::move(table));
+                out.type = Type::Bool;
+                out.reg = NewBool();
+                Emit(Op::Lookup, out.reg, 0, 0, static_cast<int>(prog.tables.size()) - 1, &c);
+                return true;
+            }
+        }
+
+        if (!ToNum(a) || !ToNum(b))
+            return false;
+
+        static const struct
+        {
+            const char *text;
+            Op op;
+        } cmps[] = {{"<", Op::Lt}, {"<=", Op::Le}, {">", Op::Gt},
+                    {">=", Op::Ge}, {"=", Op::Eq},  {"!=", Op::Ne}};
+        for (const auto &e : cmps)
+        {
+            if (op == e.text)
+            {
+                out.type = Type::Bool;
+                out.reg = NewBool();
+                Emit(e.op, out.reg, a.reg, b.reg);
+                return true;
+            }
+        }
+        return Fail("unknown operator '" + op + "'");
+    }
+
+    bool CompileIn(const Node &n, Operand &out)
+    {
+        Operand a;
+        if (!Compile(*n.kids[0], a))
+            return false;
+
+        out.type = Type::Bool;
+        out.reg = NewBool();
+
+        if (a.type == Type::Text)
+        {
+            std::vector<std::string> set;
+            for (size_t k = 1; k < n.kids.size(); ++k)
+            {
+                const Node &item = *n.kids[k];
+                if (item.kind != Node::Kind::String)
+                    return Fail("in (...) on a text column takes quoted strings");
+                set.push_back(item.text);
+            }
+            std::sort(set.begin(), set.end());
+
+            const TypedColumn &c = store.Column(a.column);
+            std::vector<uint8_t> table(c.dict.size());
+            for (size_t i = 0; i < c.dict.size(); ++i)
+                table[i] = std::binary_search(set.begin(), set.end(), c.dict[i]) ? 1 : 0;
+            prog.tables.push_back(std::move(table));
+            Emit(Op::Lookup, out.reg, 0, 0, static_cast<int>(prog.tables.size()) - 1, &c);
+        }
+        else
+        {
+            if (!ToNum(a))
+                return false;
+            std::vector<double> set;
+            for (size_t k = 1; k < n.kids.size(); ++k)
+            {
+                const Node &item = *n.kids[k];
+                if (item.kind != Node::Kind::Number)
+                    return Fail("in (...) on a numeric column takes numbers");
+                set.push_back(item.number);
+            }
+            std::sort(set.begin(), set.end());
+            prog.sets.push_back(std::move(set));
+            Emit(Op::InSet, out.reg, a.reg, 0, static_cast<int>(prog.sets.size()) - 1);
+        }
+
+        if (n.negate)
+        {
+            const int neg = NewBool();
+            Emit(Op::Not, neg, out.reg);
+            out.reg = neg;
+        }
+        return true;
+    }
+};
+
+bool FilterProgram::Compile(const GridDocument &doc, ColumnStore &store, const std::string &text,
+                            std::string &error)
+{
+    *this = FilterProgram{};
+    error.clear();
+
+    std::vector<Token> toks;
+    if (!Lex(text, toks, error))
+        return false;
+
+    Parser parser(doc, std::move(toks));
+    NodePtr root = parser.Parse(error);
+    if (!root)
+        return false;
+
+    ExprCompiler compiler{doc, store, *this, {}};
+    ExprCompiler::Operand result;
+    if (!compiler.Compile(*root, result) || result.type != ExprCompiler::Type::Bool)
+    {
+        error = compiler.error.empty() ? "expression is not a condition" : compiler.error;
+        *this = FilterProgram{};
+        return false;
+    }
+
+    resultReg = result.reg;
+    rowCount = store.RowCount();
+    return true;
+}
+
+// ============================================================
+// Batch interpreter
+// ============================================================
+
+namespace
+{
+
+template <class F> void Map1(double *d, const double *a, int n, F f)
+{
+    for (int i = 0; i < n; ++i)
+        d[i] = f(a[i]);
+}
+
+template <class F> void Map2(double *d, const double *a, const double *b, int n, F f)
+{
+    for (int i = 0; i < n; ++i)
+        d[i] = f(a[i], b[i]);
+}
+
+// True / False, or Unknown when either side is NaN (a null cell)
+template <class F> void Cmp(uint8_t *d, const double *a, const double *b, int n, F f)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        const uint8_t known = static_cast<uint8_t>((a[i] == a[i]) & (b[i] == b[i]));
+        d[i] = static_cast<uint8_t>(known * (FilterProgram::TruthFalse - f(a[i], b[i])));
+    }
+}
+
+// Null cells load as NaN so every comparison on them is unknown.
+void MaskNulls(double *d, const TypedColumn &c, int base, int n)
+{
+    if (c.nullCount == 0)
+        return;
+    for (int i = 0; i < n; ++i)
+        if (c.nulls.Test(base + i))
+            d[i] = std::numeric_limits<double>::quiet_NaN();
+}
+
+} // namespace
+
+void FilterProgram::Evaluate(Bitmap &out, const Bitmap *mask) const
+{
+    out.Resize(rowCount, false);
+    if (Empty())
+        return;
+
+    std::vector<double> num(static_cast<size_t>(numRegs) * BatchRows);
+    std::vector<uint8_t> flags(static_cast<size_t>(boolRegs) * BatchRows);
+    auto N = [&](int r) { return num.data() + static_cast<size_t>(r) * BatchRows; };
+    auto B = [&](int r) { return flags.data() + static_cast<size_t>(r) * BatchRows; };
+
+    for (const Instr &ins : prologue)
+        std::fill_n(N(ins.dst), BatchRows, constants[ins.arg]);
+
+    for (int base = 0; base < rowCount; base += BatchRows)
+    {
+        const int n = std::min(BatchRows, rowCount - base);
+        const int w0 = base / 64, wn = (n + 63) / 64;
+
+        // Refinement: batches with no surviving rows stay zero
+        if (mask && std::all_of(mask->words.begin() + w0, mask->words.begin() + w0 + wn,
+                                [](uint64_t w) { return w == 0; }))
+            continue;
+
+        for (const Instr &ins : code)
+        {
+            switch (ins.op)
+            {
+            case Op::LoadI64:
+            {
+                double *d = N(ins.dst);
+                const int64_t *s = ins.col->i64.data() + base;
+                for (int i = 0; i < n; ++i)
+                    d[i] = static_cast<double>(s[i]);
+                MaskNulls(d, *ins.col, base, n);
+                break;
+            }
+            case Op::LoadF64:
+                std::copy_n(ins.col->f64.data() + base, n, N(ins.dst));
+                MaskNulls(N(ins.dst), *ins.col, base, n);
+                break;
+            case Op::LoadDays:
+            {
+                double *d = N(ins.dst);
+                const int32_t *s = ins.col->days.data() + base;
+                for (int i = 0; i < n; ++i)
+                    d[i] = static_cast<double>(s[i]);
+                MaskNulls(d, *ins.col, base, n);
+                break;
+            }
+            case Op::Const:
+                break;
+            case Op::Neg:
+                Map1(N(ins.dst), N(ins.a), n, [](double x) { return -x; });
+                break;
+            case Op::Abs:
+                Map1(N(ins.dst), N(ins.a), n, [](double x) { return std::fabs(x); });
+                break;
+            case Op::Add:
+                Map2(N(ins.dst), N(ins.a), N(ins.b), n, [](double x, double y) { return x + y; });
+                break;
+            case Op::Sub:
+                Map2(N(ins.dst), N(ins.a), N(ins.b), n, [](double x, double y) { return x - y; });
+                break;
+            case Op::Mul:
+                Map2(N(ins.dst), N(ins.a), N(ins.b), n, [](double x, double y) { return x * y; });
+                break;
+            case Op::Div:
+                Map2(N(ins.dst), N(ins.a), N(ins.b), n, [](double x, double y) { return x / y; });
+                break;
+            case Op::Min:
+                Map2(N(ins.dst), N(ins.a), N(ins.b), n,
+                     [](double x, double y) { return y < x ? y : x; });
+                break;
+            case Op::Max:
+                Map2(N(ins.dst), N(ins.a), N(ins.b), n,
+                     [](double x, double y) { return x < y ? y : x; });
+                break;
+            case Op::Lt:
+                Cmp(B(ins.dst), N(ins.a), N(ins.b), n, [](double x, double y) { return x < y; });
+                break;
+            case Op::Le:
+                Cmp(B(ins.dst), N(ins.a), N(ins.b), n, [](double x, double y) { return x <= y; });
+                break;
+            case Op::Gt:
+                Cmp(B(ins.dst), N(ins.a), N(ins.b), n, [](double x, double y) { return x > y; });
+                break;
+            case Op::Ge:
+                Cmp(B(ins.dst), N(ins.a), N(ins.b), n, [](double x, double y) { return x >= y; });
+                break;
+            case Op::Eq:
+                Cmp(B(ins.dst), N(ins.a), N(ins.b), n, [](double x, double y) { return x == y; });
+                break;
+            case Op::Ne:
+                Cmp(B(ins.dst), N(ins.a), N(ins.b), n, [](double x, double y) { return x != y; });
+                break;
+            case Op::InSet:
+            {
+                const auto &set = sets[ins.arg];
+                uint8_t *d = B(ins.dst);
+                const double *a = N(ins.a);
+                for (int i = 0; i < n; ++i)
+                    d[i] = a[i] != a[i]                                        ? 0
+                           : std::binary_search(set.begin(), set.end(), a[i]) ? TruthTrue
+                                                                              : TruthFalse;
+                break;
+            }
+            case Op::Lookup:
+            {
+                const uint8_t *t = tables[ins.arg].data();
+                const uint32_t *codes = ins.col->codes.data() + base;
+                uint8_t *d = B(ins.dst);
+                for (int i = 0; i < n; ++i)
+                    d[i] = t[codes[i]] ? TruthTrue : TruthFalse;
+                if (ins.col->nullCount > 0)
+                    for (int i = 0; i < n; ++i)
+                        if (ins.col->nulls.Test(base + i))
+                            d[i] = 0;
+                break;
+            }
+            case Op::And:
+            {
+                uint8_t *d = B(ins.dst);
+                const uint8_t *a = B(ins.a), *b = B(ins.b);
+                for (int i = 0; i < n; ++i)
+                    d[i] = static_cast<uint8_t>(((a[i] & b[i]) & TruthTrue) | ((a[i] | b[i]) & TruthFalse));
+                break;
+            }
+            case Op::Or:
+            {
+                uint8_t *d = B(ins.dst);
+                const uint8_t *a = B(ins.a), *b = B(ins.b);
+                for (int i = 0; i < n; ++i)
+                    d[i] = static_cast<uint8_t>(((a[i] | b[i]) & TruthTrue) | ((a[i] & b[i]) & TruthFalse));
+                break;
+            }
+            case Op::Not:
+            {
+                uint8_t *d = B(ins.dst);
+                const uint8_t *a = B(ins.a);
+                for (int i = 0; i < n; ++i)
+                    d[i] = static_cast<uint8_t>(((a[i] & TruthTrue) << 1) | ((a[i] & TruthFalse) >> 1));
+                break;
+            }
+            }
+        }
+
+        // Pack the predicate into bitmap words (base is a multiple of 64)
+        const uint8_t *res = B(resultReg);
+        uint64_t *words = out.words.data() + w0;
+        for (int w = 0; w < wn; ++w)
+        {
+            const int lim = std::min(64, n - w * 64);
+            uint64_t bits = 0;
+            for (int b = 0; b < lim; ++b)
+                bits |= static_cast<uint64_t>(res[w * 64 + b] & TruthTrue) << b;
+            words[w] = mask ? bits & mask->words[w0 + w] : bits;
+        }
+    }
+    out.ClearTail();
+}
+
+} // namespace gird
@@ -0,0 +1,97 @@
+#pragma once
+#include "Bitmap.h"
+#include "ColumnStore.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gird
+{
+
+// ---- Filter expression language ----
+//
+//   abs(Delta) > 0.5 and Region in ('EMEA','APAC') and MTM < 0
+//
+// Identifiers resolve to a column id, then a label (case-insensitive), then the
+// first label that starts with the identifier as a whole word ("MTM" -> "MTM
+// P&L"). Labels with spaces can be written "quoted" or `backticked`. Strings use
+// single quotes; against Date columns they are read as yyyy-mm-dd.
+//
+// The text is parsed once and compiled to register bytecode. Evaluation runs
+// every instruction over a batch of BatchRows rows (flat arrays, no per-row
+// dispatch) and packs the final predicate straight into bitmap words.
+//
+// Conditions are three-valued, as in SQL: a comparison on a null cell is
+// unknown, `not` keeps it unknown, and only rows that come out true pass. So
+// `MTM != 0`, `not (MTM < 0)` and `Region not in (...)` all leave null rows out.
+class FilterProgram
+{
+  public:
+    static constexpr int BatchRows = 2048;
+
+    // Returns false (and leaves the program empty) on a parse or type error.
+    bool Compile(const GridDocument &doc, ColumnStore &store, const std::string &text,
+                 std::string &error);
+
+    [[nodiscard]] bool Empty() const { return resultReg < 0; }
+
+    // Evaluates rows [0, RowCount) of the store the program was compiled against.
+    // With a `mask`, only batches holding masked rows run and out is ANDed with it.
+    void Evaluate(Bitmap &out, const Bitmap *mask = nullptr) const;
+
+    // Truth bits of a bool register; neither set = unknown
+    static constexpr uint8_t TruthTrue = 1;
+    static constexpr uint8_t TruthFalse = 2;
+
+    enum class Op : uint8_t
+    {
+        LoadI64,  // num[dst] = column i64
+        LoadF64,  // num[dst] = column f64
+        LoadDays, // num[dst] = column day number
+        Const,    // num[dst] = constants[arg] (hoisted out of the batch loop)
+        Neg,
+        Abs,
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Min,
+        Max,
+        // Bool registers hold True / False / Unknown (TruthTrue, TruthFalse, 0)
+        Lt, // bool[dst] = num[a] < num[b]; Unknown when either side is NaN (null)
+        Le,
+        Gt,
+        Ge,
+        Eq,
+        Ne,
+        InSet,  // bool[dst] = num[a] in sets[arg]
+        Lookup, // bool[dst] = tables[arg][codes[row]] for a String/Date column
+        And,    // Kleene logic: false wins over unknown
+        Or,     // true wins over unknown
+        Not     // swaps true and false, keeps unknown
+    };
+
+    struct Instr
+    {
+        Op op;
+        uint16_t dst = 0, a = 0, b = 0;
+        int32_t arg = -1;                  // constant / set / table index
+        const TypedColumn *col = nullptr;  // loads and lookups
+    };
+
+  private:
+    friend struct ExprCompiler;
+
+    std::vector<Instr> prologue; // constants, run once per Evaluate
+    std::vector<Instr> code;     // run once per batch
+    std::vector<double> constants;
+    std::vector<std::vector<double>> sets;     // sorted
+    std::vector<std::vector<uint8_t>> tables;  // per dictionary code
+    int numRegs = 0;
+    int boolRegs = 0;
+    int resultReg = -1; // bool register holding the predicate
+    int rowCount = 0;
+};
+
+} // namespace gird
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GridFramework.h"
+#include <cassert>
 #include <random>
 #include <ctime>
 #include <iomanip>
@@ -1,10 +1,450 @@
 #include "GridFramework.h"
+#include "CellCache.h"
+#include "ColumnStore.h"
+#include "CustomAggregate.h"
+#include "Filter.h"
+#include "FilterExpr.h"
+#include "GroupBy.h"
+#include "Pivot.h"
+#include "RollupCache.h"
+#include "ThreadPool.h"
+#include "TrigramIndex.h"
 #include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <limits>
 #include <numeric>
 
 namespace gird
 {
 
+// Aggregate states behind vm->groupNodes. Grouped views keep each node's
+// rolled-up states, sketches and custom states (node index * plan.Slots(),
+// SketchSlots(), CustomSlots());
+// an ungrouped grand total has none and is aggregated on first display, on a
+// worker when it spans many rows.
+struct SummaryStates
+{
+    std::vector<AggState> states;
+    std::vector<SketchState> sketches;
+    std::vector<CustomState> customs;
+};
+
+struct GroupSummaries
+{
+    AggPlan plan;
+    std::vector<AggState> states;
+    std::vector<SketchState> sketches;
+    std::vector<CustomState> customs;
+    bool rolledUp = false; // states are valid for every node
+
+    // Pivot mode: the pivot values behind the view's pivot columns (keys of
+    // firstCol + k * totals.size() + a mirror aggregate column totals[a])
+    PivotKeys pivotKeys;
+    std::vector<int> pivotTotals;
+    int pivotFirstCol = -1;
+    PivotCube cube;
+
+    // What the groups were built from (ResortRows keeps them while these hold)
+    std::vector<GroupByLevel> levels;
+    uint64_t generation = 0;
+
+    std::future<SummaryStates> job;
+    int jobNode = -1;
+    std::shared_ptr<std::atomic<bool>> cancel;
+};
+
+namespace
+{
+
+// Row count above which a summary scan runs on a worker
+constexpr int AsyncSummaryRows = 1 << 18;
+
+// Column limit of an ImGui table; pivot values past it are dropped
+constexpr int MaxViewColumns = 512;
+
+void FillSummary(GroupNode &node, const AggPlan &plan, const AggState *states,
+                 const SketchState *sketches, const CustomState *customs, size_t columns)
+{
+    node.summaryByCol.assign(columns, std::string{});
+    if (!node.summaryByCol.empty())
+        node.summaryByCol[0] = "Count: " + IntegerText(node.end - node.begin);
+    plan.Format(states, sketches, customs, node.end - node.begin, node.summaryByCol);
+    node.summaryReady = true;
+}
+
+// Group columns in order; a group column that is also a sort key orders its groups
+std::vector<GroupByLevel> GroupLevels(const GridDocument &doc, const GridViewModel &vm)
+{
+    std::vector<GroupByLevel> levels;
+    for (const auto &id : vm.groupByColumnIds)
+    {
+        const int col = GridController::FindColumn(doc, id);
+        if (col < 0)
+            continue; // column not found: treat as ungrouped at this level
+        GroupByLevel lv{col, false};
+        for (const auto &k : vm.activeSortKeys)
+            if (k.column_id == id)
+                lv.descending = (k.dir == SortDir::Desc);
+        levels.push_back(lv);
+    }
+    return levels;
+}
+
+// Shortest text that parses back to exactly `x`
+std::string ExactText(double x)
+{
+    char buf[32];
+    const auto r = std::to_chars(buf, buf + sizeof(buf), x);
+    return std::string(buf, r.ptr);
+}
+
+// The column filter selecting the rows whose typed group key (GroupKeys::KeyOf)
+// equals the one at `row`. False if it cannot be written as one.
+bool KeyFilter(const ColumnDef &def, const TypedColumn &c, int row, ColumnFilter &out)
+{
+    out = ColumnFilter{def.id, FilterOp::In, {}, {}, {}};
+    if (c.nullCount > 0 && c.nulls.Test(row))
+    {
+        out.op = FilterOp::IsNull;
+        return true;
+    }
+    switch (c.type)
+    {
+    case ValueType::Int64:
+        out.values.push_back(IntegerText(c.i64[row], NumberFormat{})); // no separators
+        return true;
+    case ValueType::Bool:
+        out.values.push_back(c.i64[row] ? "true" : "false");
+        return true;
+    case ValueType::Double:
+    {
+        // Key q = round(value * perBucket) as GroupKeys computes it. That is
+        // monotonic in the value, so the bucket is a range; its bounds start
+        // from (q -+ 0.5) / perBucket and step by ulps onto the exact last
+        // values keyed q, as both the product and the division round.
+        const double perBucket = def.groupBucket > 0 ? 1.0 / def.groupBucket : 100.0;
+        auto keyOf = [&](double v) { return std::round(v * perBucket); };
+        const double q = keyOf(c.f64[row]);
+        if (!std::isfinite(q) || std::fabs(q) >= 9.0e18)
+            return false; // NaN or a clamped huge key
+        const double inf = std::numeric_limits<double>::infinity();
+        double lo = (q - 0.5) / perBucket;
+        while (keyOf(lo) < q)
+            lo = std::nextafter(lo, inf);
+        while (keyOf(std::nextafter(lo, -inf)) == q)
+            lo = std::nextafter(lo, -inf);
+        double hi = (q + 0.5) / perBucket;
+        while (keyOf(hi) > q)
+            hi = std::nextafter(hi, -inf);
+        while (keyOf(std::nextafter(hi, inf)) == q)
+            hi = std::nextafter(hi, inf);
+        out.op = FilterOp::Range;
+        out.lo = ExactText(lo);
+        out.hi = ExactText(hi);
+        return true;
+    }
+    case ValueType::String:
+    case ValueType::Date:
+    default:
+        out.values.push_back(c.dict[c.codes[row]]); // matched as stored
+        return true;
+    }
+}
+
+} // namespace
+
+GridController::GridController() = default;
+GridController::~GridController() = default;
+
+ColumnStore &GridController::Columns() const
+{
+    if (!store)
+        store = std::make_unique<ColumnStore>();
+    else if (!store->Current(*doc))
+        CancelSummaryJob(); // its worker reads the columns about to change
+    store->Sync(*doc);
+    return *store;
+}
+
+const FilterProgram *GridController::CompiledExpression() const
+{
+    const std::string &text = doc->filter.expression;
+    if (text.empty())
+    {
+        vm->filterError.clear();
+        return nullptr;
+    }
+
+    // Parse + compile once per text (and per column store generation)
+    ColumnStore &cs = Columns();
+    if (!expr || text != exprText || cs.Generation() != exprGeneration)
+    {
+        if (!expr)
+            expr = std::make_unique<FilterProgram>();
+        expr->Compile(*doc, cs, text, vm->filterError);
+        exprText = text;
+        exprGeneration = cs.Generation();
+    }
+    return expr->Empty() ? nullptr : expr.get();
+}
+
+ThreadPool &GridController::Workers() const
+{
+    if (!workers)
+        workers = std::make_unique<ThreadPool>();
+    return *workers;
+}
+
+CellTextCache &GridController::CellTexts() const
+{
+    if (!cellTexts)
+        cellTexts = std::make_unique<CellTextCache>();
+    return *cellTexts;
+}
+
+const TrigramIndex *GridController::TextIndex() const
+{
+    if (!doc->prefs.textSearchIndex)
+        return nullptr;
+
+    // Keyed on the text columns alone: ticks that only move numbers keep it
+    ColumnStore &cs = Columns();
+    std::vector<int> textCols;
+    for (int c = 0; c < static_cast<int>(doc->columns.size()); ++c)
+    {
+        const ValueType t = doc->columns[c].type;
+        if (t == ValueType::String || t == ValueType::Date)
+            textCols.push_back(c);
+    }
+    const uint64_t generation = cs.Generation(textCols);
+    auto collect = [&]
+    {
+        if (textIndexBuild.valid() &&
+            textIndexBuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            textIndex = textIndexBuild.get();
+        return textIndex && textIndex->generation == generation;
+    };
+    if (collect())
+        return textIndex.get();
+
+    // Stale or missing: snapshot the text columns here and build on a worker.
+    // One build at a time; a newer generation waits for the running one.
+    if (!textIndexBuild.valid())
+    {
+        std::vector<TrigramIndex::Input> inputs;
+        for (int c : textCols)
+            inputs.push_back(TrigramIndex::Snapshot(c, cs.Column(c)));
+        const int rows = cs.RowCount();
+        textIndexBuild = Workers().Submit(
+            [inputs = std::move(inputs), generation, rows]() mutable
+            {
+                auto index = std::make_shared<TrigramIndex>();
+                index->Build(std::move(inputs), rows, TrigramIndex::DefaultBudgetBytes);
+                index->generation = generation;
+                return std::shared_ptr<const TrigramIndex>(std::move(index));
+            });
+    }
+    return collect() ? textIndex.get() : nullptr;
+}
+
+int GridController::FindNext(const std::string &text, int afterRenderRow)
+{
+    const int count = static_cast<int>(vm->indices.size());
+    if (text.empty() || count == 0 || vm->renderRows.Size() == 0)
+        return -1;
+
+    ColumnStore &cs = Columns();
+    if (text != findHitsText || cs.Generation() != findHitsGeneration ||
+        findHits.size != cs.RowCount())
+    {
+        EvaluateQuickText(*doc, cs, text, findHits, nullptr,
+                          text.size() >= 3 ? TextIndex() : nullptr);
+        findHitsText = text;
+        findHitsGeneration = cs.Generation();
+    }
+
+    // Data rows appear in vm->indices order, so walk positions from the one
+    // after the current render row (a header's rows follow it)
+    int from = 0;
+    if (afterRenderRow >= 0 && afterRenderRow < vm->renderRows.Size())
+    {
+        const RenderRow r = vm->renderRows.At(afterRenderRow);
+        from = r.kind == RenderRowKind::GroupHeader ? vm->groupNodes[r.groupNodeIndex].begin
+                                                    : r.position + 1;
+    }
+
+    for (int step = 0; step < count; ++step)
+    {
+        const int pos = (from + step) % count;
+        int node = -1;
+        if (!findHits.Test(vm->indices[pos]) || !vm->renderRows.Locate(pos, node))
+            continue;
+        if (node < 0)
+            return vm->renderRows.DetailIndexOf(-1, pos);
+
+        // Reveal the group. A first expansion sorts its rows, so take its first hit then.
+        const bool sorted = detailSorted[node];
+        for (int n = node; n >= 0; n = vm->groupNodes[n].parent)
+            SetGroupExpanded(n, true);
+        const GroupNode &g = vm->groupNodes[node];
+        if (sorted)
+            return vm->renderRows.DetailIndexOf(node, pos - g.begin);
+        for (int k = 0; k < g.detailRows; ++k)
+            if (findHits.Test(vm->indices[g.begin + k]))
+                return vm->renderRows.DetailIndexOf(node, k);
+    }
+    return -1;
+}
+
+void GridController::SetGroupExpanded(int groupNodeIndex, bool expanded)
+{
+    if (groupNodeIndex < 0 || groupNodeIndex >= static_cast<int>(vm->groupNodes.size()) ||
+        !vm->renderRows.Collapsible(groupNodeIndex) ||
+        vm->renderRows.Expanded(groupNodeIndex) == expanded)
+        return;
+
+    const GroupNode &g = vm->groupNodes[groupNodeIndex];
+    if (expanded && g.detailRows > 0 && !detailSorted[groupNodeIndex])
+    {
+        SortRows(vm->indices.begin() + g.begin, vm->indices.begin() + g.end);
+        detailSorted[groupNodeIndex] = 1;
+    }
+    vm->renderRows.SetExpanded(groupNodeIndex, expanded);
+
+    // Remember groups that differ from the default (by key path, across rebuilds)
+    const std::string path = GroupPath(groupNodeIndex);
+    if (expanded == vm->groupsCollapsed)
+        vm->toggledGroups.insert(path);
+    else
+        vm->toggledGroups.erase(path);
+}
+
+std::string GridController::GroupPath(int groupNodeIndex) const
+{
+    std::string path;
+    for (int n = groupNodeIndex; n >= 0; n = vm->groupNodes[n].parent)
+    {
+        const GroupNode &g = vm->groupNodes[n];
+        path.insert(0, g.columnId + '\x1f' + g.keyText + '\x1e');
+    }
+    return path;
+}
+
+std::vector<ValueCount> GridController::GroupCounts(const std::string &colId) const
+{
+    std::vector<ValueCount> out;
+    const int col = FindColumn(*doc, colId);
+    if (col < 0)
+        return out;
+
+    ColumnStore &cs = Columns();
+    const BitmapIndex *index = cs.Index(col);
+    if (!index)
+        return out;
+
+    // Count against the other predicates: under All, everything but this
+    // column's filters; under Any, a value in this column's set passes on its
+    // own, so only quick text and the expression still apply
+    FilterState others = doc->filter;
+    if (others.combine == FilterCombine::Any)
+        others.columns.clear();
+    else
+        std::erase_if(others.columns, [&](const ColumnFilter &f) { return f.column_id == colId; });
+
+    const Bitmap *base = nullptr;
+    if (hasSelection && others == doc->filter && selection.size == cs.RowCount())
+        base = &selection;
+    else if (FilterIsActive(others))
+    {
+        if (!hasCountsBase || countsGeneration != cs.Generation() || countsFilter != others)
+        {
+            FilterInputs in;
+            in.expr = CompiledExpression();
+            in.text = others.quickText.size() >= 3 ? TextIndex() : nullptr;
+            EvaluateFilter(*doc, cs, others, in, countsBase);
+            countsFilter = std::move(others);
+            countsGeneration = cs.Generation();
+            hasCountsBase = true;
+        }
+        base = &countsBase;
+    }
+
+    const TypedColumn &c = cs.Column(col);
+    for (uint32_t key = 0; key < index->rowsByKey.size(); ++key)
+    {
+        const RoaringBitmap &rows = index->rowsByKey[key];
+        const int n = base ? rows.AndCardinality(*base) : rows.Cardinality();
+        if (n > 0)
+            out.push_back({index->KeyLabel(c, key), n});
+    }
+    std::sort(out.begin(), out.end(),
+              [](const ValueCount &a, const ValueCount &b) { return a.label < b.label; });
+    return out;
+}
+
+bool GridController::DrillDownFilters(int groupNodeIndex, std::vector<ColumnFilter> &pins,
+                                      std::string *why) const
+{
+    auto refuse = [&](const char *reason)
+    {
+        if (why)
+            *why = reason;
+        return false;
+    };
+    if (groupNodeIndex < 0 || groupNodeIndex >= static_cast<int>(vm->groupNodes.size()) ||
+        vm->groupNodes[groupNodeIndex].columnId.empty())
+        return false;
+
+    ColumnStore &cs = Columns();
+    for (int n = groupNodeIndex; n >= 0; n = vm->groupNodes[n].parent)
+    {
+        const GroupNode &g = vm->groupNodes[n];
+        const int col = FindColumn(*doc, g.columnId);
+        if (col < 0)
+            continue;
+        if (!doc->columns[col].typedGroupKey || g.keyRow < 0 || g.keyRow >= cs.RowCount())
+            return refuse("Drill-down needs typed group keys (ColumnDef::typedGroupKey)");
+        ColumnFilter pin;
+        if (!KeyFilter(doc->columns[col], cs.Column(col), g.keyRow, pin))
+            return refuse("This group's key cannot be expressed as a filter");
+        pins.push_back(std::move(pin));
+    }
+
+    if (doc->filter.combine == FilterCombine::Any)
+        for (const ColumnFilter &f : doc->filter.columns)
+            if (std::none_of(pins.begin(), pins.end(),
+                             [&](const ColumnFilter &p) { return p.column_id == f.column_id; }))
+                return refuse("Drill-down needs \"Match all\": under \"Match any\" the other "
+                              "column filters would widen it");
+    return true;
+}
+
+bool GridController::CanDrillDown(int groupNodeIndex, std::string *why) const
+{
+    std::vector<ColumnFilter> pins;
+    return DrillDownFilters(groupNodeIndex, pins, why);
+}
+
+bool GridController::DrillDown(int groupNodeIndex)
+{
+    std::vector<ColumnFilter> pins;
+    if (!DrillDownFilters(groupNodeIndex, pins, nullptr))
+        return false;
+
+    auto &filters = doc->filter.columns;
+    for (ColumnFilter &pin : pins)
+    {
+        std::erase_if(filters, [&](const ColumnFilter &f) { return f.column_id == pin.column_id; });
+        filters.push_back(std::move(pin));
+    }
+    doc->filter.combine = FilterCombine::All;
+    vm->dirtyIndices = true;
+    return true;
+}
+
 const ColumnDef *GridController::FindCol(const std::string &id) const
 {
     if (!doc)
@@ -21,7 +461,7 @@ int GridController::ColumnIndexByUserId(int user_id) const
     return user_id;
 }
 
-static int cmp_values_typed(ValueType t, const Value &a, const Value &b)
+int GridController::CompareValues(ValueType t, const Value &a, const Value &b)
 {
     switch (t)
     {
@@ -78,66 +518,104 @@ void GridController::RebuildIndices() const
 {
     if (!doc || !vm || !doc->source)
         return;
+    StageTimer timer(vm->pipelineStats, PipelineStage::Indices);
 
-    const int n = doc->source->RowCount();
-    vm->indices.resize(n);
-    std::iota(vm->indices.begin(), vm->indices.end(), 0);
-
-    std::vector<SortKey> effective = vm->activeSortKeys;
-
-    // Prepend all group-by columns as leading sort keys (in order)
-    for (auto it = vm->groupByColumnIds.rbegin(); it != vm->groupByColumnIds.rend(); ++it)
+    // Filter: one typed pass per predicate into a bitmap, then one compaction.
+    // While the user narrows the filter (typing on), only the rows that survived
+    // the previous pass are re-tested.
+    const bool hadSelection = hasSelection;
+    hasSelection = FilterIsActive(doc->filter);
+    vm->filterStats = {};
+    if (hasSelection)
     {
-        bool already = false;
-        for (auto &k : effective)
-            if (k.column_id == *it)
-            {
-                already = true;
-                break;
-            }
-        if (!already)
-            effective.insert(effective.begin(), SortKey{*it, SortDir::Asc, {}});
+        ColumnStore &cs = Columns();
+        FilterInputs in;
+        in.expr = CompiledExpression();
+        in.text = doc->filter.quickText.size() >= 3 ? TextIndex() : nullptr;
+        in.stats = &vm->filterStats;
+        if (hadSelection && selectionGeneration == cs.Generation() &&
+            FilterRefines(*doc, selectionFilter, doc->filter))
+            RefineFilter(*doc, cs, in, selectionFilter, selection);
+        else
+            EvaluateFilter(*doc, cs, in, selection);
+        selectionFilter = doc->filter;
+        selectionGeneration = cs.Generation();
+        selection.ToIndices(vm->indices);
     }
-
-    // (Filtering will go here later)
-
-    if (!effective.empty())
+    else
     {
-        std::ranges::stable_sort(vm->indices,
-                                 [&](int ra, int rb)
-                                 {
-                                     const auto &rowA = doc->source->RowAt(ra);
-                                     const auto &rowB = doc->source->RowAt(rb);
-
-                                     for (const auto &key : effective)
-                                     {
-                                         const ColumnDef *col = FindCol(key.column_id);
-                                         if (!col || !col->getValue)
-                                             continue;
+        vm->filterError.clear();
+        const int n = doc->source->RowCount();
+        vm->indices.resize(n);
+        std::iota(vm->indices.begin(), vm->indices.end(), 0);
+    }
 
-                                         Value va = col->getValue(rowA);
-                                         Value vb = col->getValue(rowB);
+    // Grouped views order rows per group (RebuildGroups), and only when detail
+    // rows are shown; the group columns are not sort keys.
+    if (vm->groupByColumnIds.empty())
+        SortRows(vm->indices.begin(), vm->indices.end());
 
-                                         int c = cmp_values_typed(col->type, va, vb);
-                                         if (c == 0)
-                                             continue;
+    vm->dirtyIndices = false;
+    vm->dirtyGroups = true;
+}
+bool GridController::SortRows(std::vector<int>::iterator first,
+                              std::vector<int>::iterator last) const
+{
+    struct Key
+    {
+        const ColumnDef *col;
+        bool asc;
+    };
+    std::vector<Key> keys;
+    for (const auto &k : vm->activeSortKeys)
+        if (const ColumnDef *col = FindCol(k.column_id); col && col->getValue)
+            keys.push_back({col, k.dir == SortDir::Asc});
+    if (keys.empty())
+        return false;
 
-                                         const bool asc = (key.dir == SortDir::Asc);
-                                         return asc ? (c < 0) : (c > 0);
-                                     }
-                                     return ra < rb;
-                                 });
+    std::stable_sort(first, last,
+                     [&](int ra, int rb)
+                     {
+                         const auto &rowA = doc->source->RowAt(ra);
+                         const auto &rowB = doc->source->RowAt(rb);
 
-        vm->dirtyIndices = false;
-        vm->dirtyGroups = true;
-    }
+                         for (const auto &key : keys)
+                         {
+                             const int c = CompareValues(key.col->type, key.col->getValue(rowA),
+                                                         key.col->getValue(rowB));
+                             if (c != 0)
+                                 return key.asc ? (c < 0) : (c > 0);
+                         }
+                         return ra < rb;
+                     });
+    return true;
 }
+
 void GridController::RebuildGroups()
 {
+    StageTimer timer(vm->pipelineStats, PipelineStage::Groups);
     vm->groupNodes.clear();
-    vm->renderRows.clear();
+    vm->renderRows.Clear();
+    detailSorted.clear();
+
+    // Summaries are formatted lazily (EnsureSummaries); drop the previous groups' states
+    CancelSummaryJob();
+    if (!summaries)
+        summaries = std::make_unique<GroupSummaries>();
+    GroupSummaries &sum = *summaries;
+    sum.plan = AggPlan::Resolve(*doc, *vm, Columns());
+    sum.states.clear();
+    sum.sketches.clear();
+    sum.customs.clear();
+    sum.rolledUp = false;
+    sum.cube.Clear();
+
+    const std::vector<GroupByLevel> levels = GroupLevels(*doc, *vm);
+    sum.levels = levels;
+    sum.generation = Columns().Generation();
 
-    // Optional grand total header at very top
+    // Optional grand total header at very top; when grouped, its summaries are
+    // rolled up from the top-level groups below
     if (vm->showGrandTotal)
     {
         GroupNode total;
@@ -145,29 +623,262 @@ void GridController::RebuildGroups()
         total.label = "Grand total";
         total.begin = 0;
         total.end = static_cast<int>(vm->indices.size());
-        total.summaryByCol = ComputeSummaries(total.begin, total.end); // must align to view_columns
-
-        int idx = static_cast<int>(vm->groupNodes.size());
         vm->groupNodes.push_back(std::move(total));
-        vm->renderRows.push_back({RenderRowKind::GroupHeader, 0, -1, idx});
     }
 
-    if (vm->groupByColumnIds.empty())
+    // Ungrouped: the (already sorted) rows follow the grand total
+    if (levels.empty())
     {
-        vm->renderRows.reserve(vm->renderRows.size() + vm->indices.size());
-        for (int src : vm->indices)
-            vm->renderRows.push_back({RenderRowKind::DataRow, 0, src, -1});
+        if (!vm->groupByColumnIds.empty())
+            SortRows(vm->indices.begin(), vm->indices.end());
+        vm->renderRows.Build(vm->groupNodes, std::vector<char>(vm->groupNodes.size(), 1),
+                             vm->indices, static_cast<int>(vm->indices.size()));
         vm->dirtyGroups = false;
         vm->dirtyRenderRows = false;
         return;
     }
 
-    BuildGroupLevel(0, 0, static_cast<int>(vm->indices.size()), 0);
+    std::vector<GroupByNode> groups;
+    if (!rollups)
+        rollups = std::make_unique<RollupCache>();
+    rollups->GroupBy(*doc, Columns(), levels, sum.plan, Workers(), vm->indices, groups);
+
+    // Keep every node's states (grand total first, if shown) for EnsureSummaries
+    const size_t slots = sum.plan.Slots();
+    const size_t sketchSlots = sum.plan.SketchSlots();
+    sum.states.assign((vm->groupNodes.size() + groups.size()) * slots, AggState{});
+    const size_t customSlots = sum.plan.CustomSlots();
+    sum.sketches.assign((vm->groupNodes.size() + groups.size()) * sketchSlots, SketchState{});
+    sum.customs.assign((vm->groupNodes.size() + groups.size()) * customSlots, CustomState{});
+    sum.rolledUp = true;
+    if (vm->showGrandTotal)
+        for (const GroupByNode &g : groups)
+            if (g.parent < 0)
+                sum.plan.Merge(g.aggs.data(), g.sketches.data(), g.customs.data(), sum.states.data(),
+                               sum.sketches.data(), sum.customs.data());
+
+    const int leafLevel = static_cast<int>(levels.size()) - 1;
+    const int firstNode = static_cast<int>(vm->groupNodes.size());
+    vm->groupNodes.reserve(firstNode + groups.size());
+    for (GroupByNode &g : groups)
+    {
+        const int col = levels[g.level].docCol;
+        const std::string key = GetGroupKey(*doc, col, doc->source->RowAt(g.keyRow));
+
+        GroupNode node;
+        node.indent = g.level;
+        node.label = doc->columns[col].label + "=" + key;
+        node.columnId = doc->columns[col].id;
+        node.keyText = key;
+        node.keyRow = g.keyRow;
+        node.begin = g.begin;
+        node.end = g.end;
+        node.parent = g.parent < 0 ? -1 : firstNode + g.parent;
+        node.detailRows = (g.level == leafLevel && vm->showDetailRows) ? g.end - g.begin : 0;
+
+        const int node_idx = static_cast<int>(vm->groupNodes.size());
+        std::copy(g.aggs.begin(), g.aggs.end(), sum.states.begin() + node_idx * slots);
+        std::move(g.sketches.begin(), g.sketches.end(), sum.sketches.begin() + node_idx * sketchSlots);
+        std::copy(g.customs.begin(), g.customs.end(), sum.customs.begin() + node_idx * customSlots);
+        vm->groupNodes.push_back(std::move(node));
+    }
+
+    // Pivot cells; keys read before the store changed wait for the view columns to follow
+    if (sum.pivotFirstCol >= 0)
+    {
+        if (sum.pivotKeys.generation == Columns().Generation())
+            sum.cube.Build(sum.plan, Workers(), sum.pivotKeys, vm->indices, groups, leafLevel, firstNode);
+        else
+            vm->dirtyViewColumns = true;
+    }
+
+    // Expand state: the default, flipped for remembered groups
+    const int nodeCount = static_cast<int>(vm->groupNodes.size());
+    std::vector<char> expanded(nodeCount, vm->groupsCollapsed ? 0 : 1);
+    if (!vm->toggledGroups.empty())
+        for (int n = firstNode; n < nodeCount; ++n)
+            if (vm->toggledGroups.count(GroupPath(n)))
+                expanded[n] = !expanded[n];
+
+    // Detail rows are put in sort order when their group is first expanded
+    detailSorted.assign(nodeCount, 0);
+    for (int n = firstNode; n < nodeCount; ++n)
+    {
+        const GroupNode &g = vm->groupNodes[n];
+        if (g.detailRows > 0 && expanded[n])
+        {
+            SortRows(vm->indices.begin() + g.begin, vm->indices.begin() + g.end);
+            detailSorted[n] = 1;
+        }
+    }
+
+    vm->renderRows.Build(vm->groupNodes, expanded, vm->indices, 0);
 
     vm->dirtyGroups = false;
     vm->dirtyRenderRows = false;
 }
 
+bool GridController::ResortRows()
+{
+    if (!doc || !vm || !summaries || vm->dirtyIndices || vm->dirtyGroups || vm->dirtyRenderRows)
+        return false;
+    GroupSummaries &sum = *summaries;
+    const std::vector<GroupByLevel> levels = GroupLevels(*doc, *vm);
+    const bool sameLevels = std::equal(levels.begin(), levels.end(), sum.levels.begin(), sum.levels.end(),
+                                       [](const GroupByLevel &a, const GroupByLevel &b)
+                                       { return a.docCol == b.docCol && a.descending == b.descending; });
+    if (!sameLevels || sum.generation != Columns().Generation())
+        return false;
+
+    // Without sort keys rows fall back to source order, as a rebuild leaves them
+    auto resort = [&](std::vector<int>::iterator first, std::vector<int>::iterator last)
+    {
+        if (!SortRows(first, last))
+            std::sort(first, last);
+    };
+
+    // The render list reads rows by position, so sorting inside the ranges is all it takes
+    if (levels.empty())
+    {
+        resort(vm->indices.begin(), vm->indices.end());
+        return true;
+    }
+    for (int n = 0; n < static_cast<int>(vm->groupNodes.size()); ++n)
+    {
+        const GroupNode &g = vm->groupNodes[n];
+        if (g.detailRows == 0)
+            continue;
+        detailSorted[n] = vm->renderRows.Expanded(n);
+        if (detailSorted[n])
+            resort(vm->indices.begin() + g.begin, vm->indices.begin() + g.end);
+    }
+    return true;
+}
+
+void GridController::EnsureSummaries(int firstRenderRow, int lastRenderRow)
+{
+    if (!doc || !vm || !summaries)
+        return;
+    GroupSummaries &sum = *summaries;
+    const int nodeCount = static_cast<int>(vm->groupNodes.size());
+    StageTimer timer(vm->pipelineStats, PipelineStage::Summaries);
+    bool worked = false;
+
+    // Collect a finished background summary
+    if (sum.job.valid() &&
+        sum.job.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        worked = true;
+        const SummaryStates done = sum.job.get();
+        if (sum.jobNode >= 0 && sum.jobNode < nodeCount)
+            FillSummary(vm->groupNodes[sum.jobNode], sum.plan, done.states.data(), done.sketches.data(),
+                        done.customs.data(), vm->viewColumns.size());
+        sum.jobNode = -1;
+    }
+
+    firstRenderRow = std::max(firstRenderRow, 0);
+    lastRenderRow = std::min(lastRenderRow, vm->renderRows.Size());
+    for (int rr = firstRenderRow; rr < lastRenderRow; ++rr)
+    {
+        const RenderRow r = vm->renderRows.At(rr);
+        if (r.kind != RenderRowKind::GroupHeader || r.groupNodeIndex < 0 ||
+            r.groupNodeIndex >= nodeCount)
+            continue;
+        GroupNode &node = vm->groupNodes[r.groupNodeIndex];
+        if (node.summaryReady)
+            continue;
+
+        if (sum.rolledUp)
+        {
+            worked = true;
+            FillSummary(node, sum.plan, sum.states.data() + r.groupNodeIndex * sum.plan.Slots(),
+                        sum.sketches.data() + r.groupNodeIndex * sum.plan.SketchSlots(),
+                        sum.customs.data() + r.groupNodeIndex * sum.plan.CustomSlots(),
+                        vm->viewColumns.size());
+            sum.cube.Format(r.groupNodeIndex, sum.plan, sum.pivotFirstCol, sum.pivotTotals,
+                            node.summaryByCol);
+            continue;
+        }
+
+        // No group-by states (ungrouped grand total): scan the rows, on a worker when long
+        if (node.end - node.begin < AsyncSummaryRows || sum.plan.Empty())
+        {
+            worked = true;
+            node.summaryByCol = ComputeSummaries(node.begin, node.end);
+            node.summaryReady = true;
+            continue;
+        }
+        if (sum.job.valid())
+            continue; // one at a time; the header shows a placeholder meanwhile
+        worked = true;
+
+        // Every source row (any order): the job aggregates the columns front to
+        // back and needs no copy of the row list
+        const int count = node.end - node.begin;
+        const bool allRows =
+            count == Columns().RowCount() && count == static_cast<int>(vm->indices.size());
+        std::vector<int> rows;
+        if (!allRows)
+            rows.assign(vm->indices.begin() + node.begin, vm->indices.begin() + node.end);
+
+        sum.cancel = std::make_shared<std::atomic<bool>>(false);
+        sum.jobNode = r.groupNodeIndex;
+        sum.job = Workers().Submit(
+            [plan = sum.plan, cancel = sum.cancel, rows = std::move(rows), allRows, count]
+            {
+                SummaryStates out{std::vector<AggState>(plan.Slots()),
+                                  std::vector<SketchState>(plan.SketchSlots()),
+                                  std::vector<CustomState>(plan.CustomSlots())};
+                constexpr int Chunk = 1 << 16;
+                for (int i = 0; i < count && !cancel->load(std::memory_order_relaxed); i += Chunk)
+                {
+                    const int m = std::min(Chunk, count - i);
+                    if (allRows)
+                        plan.AccumulateRange(i, m, out.states.data(), out.sketches.data(),
+                                             out.customs.data());
+                    else
+                        plan.Accumulate(rows.data() + i, m, out.states.data(), out.sketches.data(),
+                                        out.customs.data());
+                }
+                return out;
+            },
+            wake);
+    }
+    if (!worked)
+        timer.Dismiss(); // every summary on screen was ready: keep the samples meaningful
+}
+
+const PipelineStats &GridController::Stats() const
+{
+    PipelineStats &stats = vm->pipelineStats;
+    stats.sourceRows = doc && doc->source ? doc->source->RowCount() : 0;
+    stats.rows = static_cast<int>(vm->indices.size());
+    stats.groups = static_cast<int>(vm->groupNodes.size());
+    stats.renderRows = vm->renderRows.Size();
+    return stats;
+}
+
+bool GridController::NeedsFrame() const
+{
+    if (!vm)
+        return false;
+    if (vm->dirtyIndices || vm->dirtyGroups || vm->dirtyViewColumns || vm->dirtyRenderRows)
+        return true;
+    if (!summaries || !summaries->job.valid())
+        return false;
+    return !wake || summaries->job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+void GridController::CancelSummaryJob() const
+{
+    if (!summaries || !summaries->job.valid())
+        return;
+    summaries->cancel->store(true, std::memory_order_relaxed);
+    summaries->job.wait();
+    summaries->job = {};
+    summaries->jobNode = -1;
+}
+
 static const char *AggTypeName(gird::AggType t)
 {
     switch (t)
@@ -184,6 +895,14 @@ static const char *AggTypeName(gird::AggType t)
         return "Avg";
     case gird::AggType::Custom:
         return "Custom";
+    case gird::AggType::DistinctCount:
+        return "Distinct";
+    case gird::AggType::Median:
+        return "Median";
+    case gird::AggType::P95:
+        return "P95";
+    case gird::AggType::TopK:
+        return "Top3";
     default:
         return "?";
     }
@@ -192,10 +911,14 @@ static std::string DocKey(const std::string &col_id) { return "doc:" + col_id; }
 
 static std::string AggKey(const AggDef &a)
 {
-    return "agg:" + std::string(AggTypeName(a.type)) + ":" + a.column_id;
+    std::string key = "agg:" + std::string(AggTypeName(a.type)) + ":" + a.column_id;
+    if (a.type == AggType::Custom)
+        key += ":" + a.customAggId + ":" + a.weightColumnId;
+    return key;
 }
 void GridController::RebuildViewColumns() const
 {
+    StageTimer timer(vm->pipelineStats, PipelineStage::ViewColumns);
     vm->viewColumns.clear();
 
     auto get_vis = [&](const std::string &key, bool def) -> bool
@@ -228,6 +951,19 @@ void GridController::RebuildViewColumns() const
         const ColumnDef *base = FindCol(a.column_id);
         const std::string baseLabel = base ? base->label : a.column_id;
         vc.label = std::string(AggTypeName(a.type)) + "(" + baseLabel + ")";
+        vc.tooltip = AggPlan::ErrorNote(a.type);
+        if (a.type == AggType::Custom)
+        {
+            // e.g. "Weighted avg(Entry Price by Notional Value)"
+            const CustomAggregator *custom = FindCustomAggregate(*doc, a.customAggId);
+            std::string args = baseLabel;
+            if (custom && custom->Weighted())
+            {
+                const ColumnDef *weight = FindCol(a.weightColumnId);
+                args += " by " + (weight ? weight->label : a.weightColumnId);
+            }
+            vc.label = (custom ? custom->Label() : "Custom:" + a.customAggId) + "(" + args + ")";
+        }
 
         vc.visible = get_vis(AggKey(a), /*default*/ true);
         vc.sortable = false;
@@ -235,73 +971,38 @@ void GridController::RebuildViewColumns() const
         vm->viewColumns.push_back(std::move(vc));
     }
 
-    vm->dirtyViewColumns = false;
-}
-
-// Recursive helper: processes one grouping level
-void GridController::BuildGroupLevel(int level, int begin, int end, int indent)
-{
-    if (level >= static_cast<int>(vm->groupByColumnIds.size()))
+    // Pivot columns: each aggregate again per value of the pivot column, after
+    // the aggregate columns (which then read as the row totals)
+    if (!summaries)
+        summaries = std::make_unique<GroupSummaries>();
+    GroupSummaries &sum = *summaries;
+    sum.pivotKeys = PivotKeys{};
+    sum.pivotTotals.clear();
+    sum.pivotFirstCol = -1;
+    vm->pivotDropped = 0;
+    const int pivotCol = vm->pivotColumnId.empty() ? -1 : FindColumn(*doc, vm->pivotColumnId);
+    if (pivotCol >= 0 && !vm->groupByColumnIds.empty() && !vm->active_aggs.empty())
     {
-        // Leaf: emit detail rows (if enabled)
-        if (vm->showDetailRows)
-        {
-            for (int i = begin; i < end; ++i)
+        const int width = static_cast<int>(vm->active_aggs.size());
+        const int firstCol = static_cast<int>(vm->viewColumns.size());
+        for (int a = 0; a < width; ++a)
+            sum.pivotTotals.push_back(firstCol - width + a);
+        sum.pivotKeys = BuildPivotKeys(*doc, Columns(), pivotCol, (MaxViewColumns - firstCol) / width);
+        sum.pivotFirstCol = firstCol;
+        vm->pivotDropped = sum.pivotKeys.dropped;
+
+        vm->viewColumns.reserve(firstCol + sum.pivotKeys.Count() * width);
+        for (int k = 0; k < sum.pivotKeys.Count(); ++k)
+            for (int total : sum.pivotTotals)
             {
-                const int src = vm->indices[i];
-                vm->renderRows.push_back({RenderRowKind::DataRow, indent, src, -1});
+                ViewColumn vc = vm->viewColumns[total]; // visibility follows the total
+                vc.pivotKey = k;
+                vc.label = sum.pivotKeys.labels[k] + ": " + vc.label;
+                vm->viewColumns.push_back(std::move(vc));
             }
-        }
-        return;
     }
 
-    // Find a column for this level
-    const std::string &col_id = vm->groupByColumnIds[level];
-    const int col_idx = FindColumn(*doc, col_id);
-    if (col_idx < 0)
-    {
-        // Column not found: treat as ungrouped at this level
-        BuildGroupLevel(level + 1, begin, end, indent);
-        return;
-    }
-
-    // Split into runs by this column's value
-    int i = begin;
-    while (i < end)
-    {
-        const int src_first = vm->indices[i];
-        const auto key = GetGroupKey(*doc, col_idx, doc->source->RowAt(src_first));
-
-        // Find run with same key
-        int run_end = i + 1;
-        while (run_end < end)
-        {
-            const int src = vm->indices[run_end];
-            const auto k = GetGroupKey(*doc, col_idx, doc->source->RowAt(src));
-            if (k != key)
-                break;
-            ++run_end;
-        }
-
-        // Emit group header for this run
-        {
-            GroupNode node;
-            node.indent = indent;
-            node.label = doc->columns[col_idx].label + "=" + key;
-            node.begin = i;
-            node.end = run_end;
-            node.summaryByCol = ComputeSummaries(i, run_end);
-
-            const int node_idx = static_cast<int>(vm->groupNodes.size());
-            vm->groupNodes.push_back(std::move(node));
-            vm->renderRows.push_back({RenderRowKind::GroupHeader, indent, -1, node_idx});
-        }
-
-        // Recurse into next level
-        BuildGroupLevel(level + 1, i, run_end, indent + 1);
-
-        i = run_end;
-    }
+    vm->dirtyViewColumns = false;
 }
 
 // Find column index by ID
@@ -318,11 +1019,11 @@ std::string GridController::GetGroupKey(const GridDocument &doc, int col_idx,
                                         const SimpleRow &row)
 {
     const auto &col = doc.columns[col_idx];
-    const Value v = col.getValue(row);
-    return col.getGroupKey(row); // reuse your existing format function
+    return col.getGroupKey ? col.getGroupKey(row) : std::string{};
 }
 
-// Compute summaries for range [begin, end) in vm.indices
+// Compute summaries for range [begin, end) in vm.indices: every aggregate in
+// one pass over the rows, reading the typed store columns.
 std::vector<std::string> GridController::ComputeSummaries(int begin, int end) const
 {
     std::vector<std::string> out;
@@ -335,136 +1036,21 @@ std::vector<std::string> GridController::ComputeSummaries(int begin, int end) co
 
     // Always show count in col0 (or leave this out if you prefer)
     if (!out.empty())
-        out[0] = "Count: " + std::to_string(count);
-
-    auto format_i64 = [](int64_t v) { return std::to_string(v); };
-    auto format_f64 = [](double v) { return std::to_string(v); };
-
-    auto agg_on_doc_col = [&](int doc_col_index, AggType type) -> std::string
-    {
-        if (doc_col_index < 0 || doc_col_index >= static_cast<int>(doc->columns.size()))
-            return {};
-        const ColumnDef &col = doc->columns[doc_col_index];
-        if (!col.getValue)
-            return {};
-
-        // Count works for any type
-        if (type == AggType::Count)
-            return std::to_string(count);
+        out[0] = "Count: " + IntegerText(count);
 
-        // Numeric aggregations: Int64 / Double
-        if (col.type == ValueType::Int64)
-        {
-            bool have = false;
-            int64_t mn = 0, mx = 0;
-            int64_t sum = 0;
-
-            for (int i = begin; i < end; ++i)
-            {
-                const int src = vm->indices[i];
-                const auto &row = doc->source->RowAt(src);
-                Value v = col.getValue(row);
-                auto p = std::get_if<int64_t>(&v);
-                if (!p)
-                    continue;
-
-                const int64_t x = *p;
-                if (!have)
-                {
-                    mn = mx = x;
-                    have = true;
-                }
-                mn = std::min(mn, x);
-                mx = std::max(mx, x);
-                sum += x;
-            }
-
-            if (!have)
-                return {};
-
-            switch (type)
-            {
-            case AggType::Min:
-                return format_i64(mn);
-            case AggType::Max:
-                return format_i64(mx);
-            case AggType::Sum:
-                return format_i64(sum);
-            case AggType::Avg:
-                return format_f64(static_cast<double>(sum) / static_cast<double>(count));
-            default:
-                return {};
-            }
-        }
-        else if (col.type == ValueType::Double)
-        {
-            bool have = false;
-            double mn = 0, mx = 0;
-            double sum = 0.0;
-
-            for (int i = begin; i < end; ++i)
-            {
-                const int src = vm->indices[i];
-                const auto &row = doc->source->RowAt(src);
-                Value v = col.getValue(row);
-                auto p = std::get_if<double>(&v);
-                if (!p)
-                    continue;
-
-                const double x = *p;
-                if (!have)
-                {
-                    mn = mx = x;
-                    have = true;
-                }
-                mn = std::min(mn, x);
-                mx = std::max(mx, x);
-                sum += x;
-            }
-
-            if (!have)
-                return {};
-
-            switch (type)
-            {
-            case AggType::Min:
-                return format_f64(mn);
-            case AggType::Max:
-                return format_f64(mx);
-            case AggType::Sum:
-                return format_f64(sum);
-            case AggType::Avg:
-                return format_f64(sum / static_cast<double>(count));
-            default:
-                return {};
-            }
-        }
-
-        // Non-numeric: only Min/Max by formatted string could be added later
-        return {};
-    };
-
-    // Fill aggregate view columns
-    for (int vc = 0; vc < static_cast<int>(vm->viewColumns.size()); ++vc)
-    {
-        const auto &vcol = vm->viewColumns[vc];
-        if (vcol.kind != ViewColumn::Kind::Agg)
-            continue;
-
-        // Find source doc column by id
-        int doc_col_index = -1;
-        for (int c = 0; c < static_cast<int>(doc->columns.size()); ++c)
-        {
-            if (doc->columns[c].id == vcol.agg.column_id)
-            {
-                doc_col_index = c;
-                break;
-            }
-        }
-
-        out[vc] = agg_on_doc_col(doc_col_index, vcol.agg.type);
-    }
+    const AggPlan plan = AggPlan::Resolve(*doc, *vm, Columns());
+    if (plan.Empty())
+        return out;
 
+    // Every source row (any order): aggregate the columns front to back
+    std::vector<AggState> states(plan.Slots());
+    std::vector<SketchState> sketches(plan.SketchSlots());
+    std::vector<CustomState> customs(plan.CustomSlots());
+    if (count == Columns().RowCount() && count == static_cast<int>(vm->indices.size()))
+        plan.AccumulateRange(0, count, states.data(), sketches.data(), customs.data());
+    else
+        plan.Accumulate(vm->indices.data() + begin, count, states.data(), sketches.data(), customs.data());
+    plan.Format(states.data(), sketches.data(), customs.data(), count, out);
     return out;
 }
 
@@ -1,16 +1,32 @@
 #pragma once
 #include <cstdint>
 #include <functional>
+#include <future>
+#include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <variant>
 #include <vector>
 
+#include "Bitmap.h"
+#include "NumberFormat.h"
+#include "PipelineStats.h"
+
 struct ImFont; // forward decl (keeps this header mostly UI-agnostic)
 
 namespace gird
 {
 class IPersistence;
+class CellTextCache;
+class ColumnStore;
+class CustomAggregator;
+class FilterProgram;
+class RollupCache;
+class ThreadPool;
+class TrigramIndex;
+struct GroupSummaries;
 
 // ---- Value / typing ----
 enum class ValueType
@@ -18,7 +34,8 @@ enum class ValueType
     String,
     Int64,
     Double,
-    Bool
+    Bool,
+    Date // held as "yyyy-mm-dd" text in Value, as a day number in typed storage
 };
 
 using Value = std::variant<std::string, int64_t, double, bool>;
@@ -29,11 +46,9 @@ inline std::string ValueToString(const Value& v) {
     if (std::holds_alternative<std::string>(v)) {
         return std::get<std::string>(v);
     } else if (std::holds_alternative<int64_t>(v)) {
-        return std::to_string(std::get<int64_t>(v));
+        return IntegerText(std::get<int64_t>(v), {});
     } else if (std::holds_alternative<double>(v)) {
-        char buf[64];
-        snprintf(buf, sizeof(buf), "%.2f", std::get<double>(v));
-        return std::string(buf);
+        return NumberText(std::get<double>(v));
     }
     return "";
 }
@@ -43,6 +58,16 @@ struct IRowSource
     virtual ~IRowSource() = default;
     virtual int RowCount() const = 0;
     virtual const SimpleRow &RowAt(int row_index) const = 0;
+
+    // Data version: bumped on every in-place row update (0 = static source).
+    virtual uint64_t Version() const { return 0; }
+
+    // Rows updated after `version`, if the source still knows them. Returning
+    // false means "unknown" and caches over the source must rebuild from scratch.
+    virtual bool ChangedRowsSince(uint64_t /*version*/, std::vector<int> & /*rows*/) const
+    {
+        return false;
+    }
 };
 
 // ---- Column definition (dictionary entry) ----
@@ -53,6 +78,30 @@ struct CellStyle
     ImFont *font = nullptr;            // optional
 };
 
+// Packed like IM_COL32 (without IMGUI_USE_BGRA_PACKED_COLOR), for UI-free code
+constexpr uint32_t PackColor(uint32_t r, uint32_t g, uint32_t b, uint32_t a = 255)
+{
+    return a << 24 | b << 16 | g << 8 | r;
+}
+
+// Conditional style of a numeric cell. A column's rules apply in order and a
+// later match wins; colours are packed ImU32 (IM_COL32), 0 = unset.
+struct StyleRule
+{
+    enum class Kind
+    {
+        Below,   // value < from: bg / text
+        Above,   // value > from: bg / text
+        Gradient // from <= value <= to: bg blends lowBg -> highBg (no match outside)
+    };
+
+    Kind kind = Kind::Above;
+    double from = 0.0;
+    double to = 0.0;
+    uint32_t bg = 0, text = 0;      // Below / Above
+    uint32_t lowBg = 0, highBg = 0; // Gradient
+};
+
 struct ColumnDef
 {
     std::string id;    // stable key for persistence
@@ -68,10 +117,22 @@ struct ColumnDef
     std::function<Value(const SimpleRow &)> getValue;
 
     std::function<std::string(const SimpleRow &)> getGroupKey;
-    // Formatting: value -> display string
+    // Typed grouping: rows are grouped on an integer key read from the column
+    // store (String: dictionary code, Int64/Bool: value, Date: day number,
+    // Double: round(value / groupBucket)) and getGroupKey only labels each group
+    // once. Leave off when getGroupKey does more than print the value.
+    bool typedGroupKey = false;
+    double groupBucket = 0.01; // Double bucket width (matches a "%.2f" key)
+    // Formatting: value -> display string. Left empty, numbers print through
+    // `number`, as do the aggregates over the column.
     std::function<std::string(const Value &)> format;
+    NumberFormat number;
 
-    // Optional conditional styling
+    // Conditional styling: rules first, then `style` (its font is not applied).
+    // Both are evaluated when a cell is first formatted and cached with its
+    // text (CellTextCache), so they cost nothing on a steady frame; clear
+    // GridController::CellTexts() after changing them.
+    std::vector<StyleRule> styleRules;
     std::function<CellStyle(const SimpleRow &, const Value &)> style;
 };
 
@@ -97,6 +158,7 @@ struct SortConfig
     std::vector<SortKey> keys;
 };
 
+// Persisted by value: new types go at the end.
 enum class AggType
 {
     Count,
@@ -104,14 +166,20 @@ enum class AggType
     Max,
     Sum,
     Avg,
-    Custom
+    Custom,
+    // Approximate, from mergeable sketches (Sketch.h)
+    DistinctCount,
+    Median,
+    P95,
+    TopK
 };
 
 struct AggDef
 {
     std::string column_id;
     AggType type = AggType::Count;
-    std::string customAggId; // later
+    std::string customAggId;    // Custom: id in GridDocument::customAggs
+    std::string weightColumnId; // Custom: weight column of a weighted aggregator
 };
 
 struct GroupConfig
@@ -121,9 +189,38 @@ struct GroupConfig
     std::vector<AggDef> aggs;
 };
 
+enum class FilterOp
+{
+    Range, // lo <= value <= hi
+    In,    // value is one of `values`
+    IsNull // cell missing or not of the column type (the others never match it)
+};
+
+// One typed predicate over a single column. Bounds and set members are kept as
+// text (numbers, or yyyy-mm-dd for Date columns) and parsed against the column
+// type when the filter is compiled, so the same shape persists for every type.
+struct ColumnFilter
+{
+    std::string column_id;
+    FilterOp op = FilterOp::Range;
+    std::string lo, hi;              // Range: inclusive bounds, empty = open
+    std::vector<std::string> values; // In: set members
+    bool operator==(const ColumnFilter &) const = default;
+};
+
+enum class FilterCombine
+{
+    All, // AND column filters together
+    Any  // OR column filters together
+};
+
 struct FilterState
 {
-    std::string quickText; // simplest first: substring match over formatted row
+    std::string quickText; // case-insensitive substring match over text columns
+    std::vector<ColumnFilter> columns;
+    FilterCombine combine = FilterCombine::All; // quick text always ANDs with the result
+    std::string expression; // filter language (FilterExpr.h), ANDed with the rest
+    bool operator==(const FilterState &) const = default;
 };
 
 struct GridPreferences
@@ -135,6 +232,17 @@ struct GridPreferences
     // UX preferences (later)
     bool zebra = true;
     bool allowMultiSelect = false;
+
+    // Build a trigram index over the text columns in the background so quick
+    // text and find answer 3+ character searches from posting lists.
+    bool textSearchIndex = true;
+
+    // Idle rendering (native app): while nothing changes, block on events
+    // instead of redrawing at vsync; input, data ticks and finished background
+    // jobs wake the window. It still redraws at least minRefreshHz times a
+    // second (0 = only when woken).
+    bool idleRendering = true;
+    float minRefreshHz = 1.0f;
 };
 
 // ---- Grid "document" (what the user is looking at) ----
@@ -148,6 +256,9 @@ struct GridDocument
 
     FilterState filter;
     GridPreferences prefs;
+
+    // Custom aggregators (AggType::Custom), looked up by AggDef::customAggId
+    std::vector<std::shared_ptr<const CustomAggregator>> customAggs;
 };
 
 // ---- Computed view model (indices, grouping, caches) ----
@@ -179,6 +290,7 @@ struct RenderRow
     int indent = 0;            // 0=year, 1=month...
     int srcRrowIndex = -1;    // valid for DataRow
     int groupNodeIndex = -1; // index into vm.group_nodes (GroupHeader)
+    int position = -1;       // index into vm.indices (DataRow)
 };
 
 struct GroupNode
@@ -186,7 +298,76 @@ struct GroupNode
     int indent = 0;
     std::string label;                       // what shows in col0 (e.g. "Year=2026", "Month=01")
     int begin = 0, end = 0;                  // range in vm.indices
+    int parent = -1;                         // index into vm.groupNodes; -1 = top level
+    int detailRows = 0;                      // rows of [begin, end) listed under the header
     std::vector<std::string> summaryByCol; // aligned to doc.columns
+    bool summaryReady = false;             // summaryByCol filled (see EnsureSummaries)
+
+    std::string columnId; // grouping column of this level (empty for grand total)
+    std::string keyText;  // group key as text (names the group in toggledGroups)
+    int keyRow = -1;      // a source row holding the key (what DrillDown pins)
+};
+
+// ---- Render list: the rows the grid draws, held implicitly ----
+// Headers and detail rows are never materialized. Each node keeps the row count
+// of its expanded body and a Fenwick tree (prefix sums) over its children's
+// visible sizes, so At() descends one level per step with a binary search and
+// expanding or collapsing a group only updates its ancestors; both cost
+// O(depth * log fanout). A node's children come first, then its detail rows.
+class RenderList
+{
+  public:
+    // `nodes` in preorder (GroupNode::parent set); `expanded` per node. Detail
+    // rows are read from `rows` (kept by reference); `topRows` rows from its start
+    // follow the top-level nodes (the ungrouped view).
+    void Build(const std::vector<GroupNode> &nodes, const std::vector<char> &expanded,
+               const std::vector<int> &rows, int topRows);
+    void Clear();
+
+    [[nodiscard]] int Size() const;
+    [[nodiscard]] RenderRow At(int index) const;
+
+    [[nodiscard]] bool Expanded(int node) const { return entries[node].expanded; }
+    // Has children or detail rows to show or hide
+    [[nodiscard]] bool Collapsible(int node) const;
+    void SetExpanded(int node, bool expanded);
+
+    // Render index of a node's header; -1 while an ancestor is collapsed.
+    [[nodiscard]] int IndexOf(int node) const;
+    // Render index of detail row `k` of `node` (-1 = the top rows); -1 if hidden.
+    [[nodiscard]] int DetailIndexOf(int node, int k) const;
+    // Node whose detail rows hold position `pos` of `rows` (-1 = the top rows);
+    // false if no node lists it.
+    [[nodiscard]] bool Locate(int pos, int &node) const;
+
+  private:
+    struct Entry
+    {
+        int parent = -1; // root for top-level nodes
+        int indent = 0;
+        int begin = 0, detail = 0, detailIndent = 0;
+        int childStart = 0, childCount = 0; // block in `children` / `fenwick`
+        int slot = 0;                       // position in the parent's block
+        int childRows = 0;                  // visible rows of all children
+        bool expanded = true;
+    };
+
+    std::vector<Entry> entries;  // one per node, then the root
+    std::vector<int> children;   // child node ids, one block per parent
+    std::vector<int> fenwick;    // children's visible sizes, one tree per block
+    std::vector<int> leaves;     // nodes with detail rows, by begin
+    const std::vector<int> *rows = nullptr;
+
+    [[nodiscard]] int Root() const { return static_cast<int>(entries.size()) - 1; }
+    [[nodiscard]] int Visible(int e) const;
+    [[nodiscard]] int Prefix(const Entry &e, int slots) const;
+    void Add(const Entry &e, int slot, int delta);
+};
+
+struct ValueCount
+{
+    std::string label;
+    int count = 0;
 };
 
 struct ViewColumn
@@ -202,15 +383,36 @@ struct ViewColumn
 
     AggDef agg;                         // column_id + agg type
     std::string label;                  // e.g. "Sum(amount)"
+    std::string tooltip;                // header hover text (error bounds of approximate aggs)
+    int pivotKey = -1;                  // Kind::Agg pivot cell: index of its pivot value (-1 = total)
     ValueType type = ValueType::Double; // display type (optional)
     bool visible = true;
     bool sortable = false;
 };
 
+// Zone-map effect of the last filter pass (range predicates on numeric/date
+// columns, counted per predicate and block).
+struct FilterStats
+{
+    int blocks = 0;   // blocks considered
+    int skipped = 0;  // [min, max] outside the range: no row tested
+    int accepted = 0; // [min, max] inside the range: whole block taken, no row tested
+
+    [[nodiscard]] double SkipRatio() const
+    {
+        return blocks ? static_cast<double>(skipped + accepted) / blocks : 0.0;
+    }
+};
+
 struct GridViewModel
 {
     // Derived
     std::vector<int> indices;      // maps visible row order -> source row index
+    std::string filterError;       // last filter expression compile error (empty = ok)
+    FilterStats filterStats;       // last filter pass
+    PipelineStats pipelineStats;   // stage timings (GridController::Stats)
+    bool showPipelineStats = false; // timings overlay
+    int pivotDropped = 0;          // pivot values past the table's column limit
     std::vector<GroupSpan> groups; // optional
 
     // State
@@ -219,8 +421,14 @@ struct GridViewModel
 
     std::vector<SortKey> activeSortKeys; // ad-hoc sort coming from ImGui header
 
+    // Find (does not filter): last hit as a render row, scrolled into view once
+    std::string findText;
+    int findRenderRow = -1;
+    bool scrollToFind = false;
+
     std::unordered_map<std::string, gird::AggType> colSummary; // per-column summary
     std::vector<std::string> groupByColumnIds;
+    std::string pivotColumnId; // grouped views: aggregates spread over this column's values
     bool showDetailRows = true; // summary-only mode: false
 
     std::vector<ViewColumn> viewColumns;
@@ -228,9 +436,14 @@ struct GridViewModel
     std::vector<AggDef> active_aggs;
 
     std::vector<GroupNode> groupNodes;
-    std::vector<RenderRow> renderRows;
+    RenderList renderRows;
     bool dirtyRenderRows = true;
 
+    // Expand/collapse: new groups start collapsed or expanded; toggledGroups
+    // holds the key paths of groups flipped from that default (kept across rebuilds)
+    bool groupsCollapsed = false;
+    std::unordered_set<std::string> toggledGroups;
+
     bool showGroupHeaders = true;
     bool showGrandTotal = false;
 
@@ -250,21 +463,120 @@ struct GridController
 
     IPersistence *persistence = nullptr;
 
+    // Called on a worker thread when a background job has a result for the next
+    // frame, so an app blocked on events (GridPreferences::idleRendering) draws
+    // it; must be thread-safe (e.g. glfwPostEmptyEvent). Data feeds ticking
+    // doc->source from other threads call it too.
+    std::function<void()> wake;
+
     // Selection (start simple)
     int selected_view_row = -1;
 
+    GridController();
+    ~GridController();
+
+    // Typed columnar mirror of doc->source (built lazily, owned here)
+    ColumnStore &Columns() const;
+    // doc->filter.expression compiled against Columns(); null if empty or invalid
+    const FilterProgram *CompiledExpression() const;
+
+    // Worker pool for background builds (created on first use)
+    ThreadPool &Workers() const;
+    // Trigram index over the text columns for the current store contents. Null
+    // while it is being (re)built on a worker, or when prefs disable it; callers
+    // then scan.
+    const TrigramIndex *TextIndex() const;
+
+    // Next render row after `afterRenderRow` (wrapping around) whose data row
+    // contains `text` in a text column, in view order; -1 if none. Collapsed
+    // groups holding the hit are expanded.
+    [[nodiscard]] int FindNext(const std::string &text, int afterRenderRow);
+
+    // Expands or collapses one group (remembered in vm->toggledGroups).
+    void SetGroupExpanded(int groupNodeIndex, bool expanded);
+
+    // Distinct values of an indexed (groupable) column with their row counts
+    // under the other predicates (this column's own filter left out, so values
+    // not yet in its IN set can be picked), from bitmap index cardinalities.
+    [[nodiscard]] std::vector<ValueCount> GroupCounts(const std::string &colId) const;
+    // Narrows the filter to one group: pins each key on the node's path by its
+    // typed value (IN on the stored value, a range over a Double bucket, IsNull
+    // for the null group) and switches to FilterCombine::All. Refuses (false,
+    // with the reason in `why`; DrillDown changes nothing) for levels keyed on
+    // getGroupKey text, or under Any with column filters off the path, which
+    // would be ORed with the pins.
+    [[nodiscard]] bool CanDrillDown(int groupNodeIndex, std::string *why = nullptr) const;
+    bool DrillDown(int groupNodeIndex);
+
     // Helpers
    [[nodiscard]] const ColumnDef *FindCol(const std::string &id) const;
     [[nodiscard]] static int FindColumn(const GridDocument &doc, const std::string &id);
     [[nodiscard]] int ColumnIndexByUserId(int userId) const;
+    // -1 / 0 / 1 by the column type (missing values compare as 0 / "" / false)
+    [[nodiscard]] static int CompareValues(ValueType t, const Value &a, const Value &b);
     [[nodiscard]] static std::string GetGroupKey(const GridDocument &doc, int colIdx,
                                             const SimpleRow &row);
     std::vector<std::string> ComputeSummaries(int begin, int end) const;
+    // Fills summaryByCol of the group headers among render rows [first, last)
+    // that are not ready yet; the result is memoized on the node. A summary that
+    // needs a scan over many rows runs on a worker, and its header stays not
+    // ready until a later call collects the result.
+    void EnsureSummaries(int firstRenderRow, int lastRenderRow);
+    // True when the next frame has work to show: dirty view state, or a
+    // summary computed in the background waiting to be collected (or running,
+    // when there is no `wake` to signal its end). Idle rendering blocks only
+    // while this is false and the source version is unchanged.
+    [[nodiscard]] bool NeedsFrame() const;
+    // Stage timings of this view, with the current row / group / render-row counts
+    [[nodiscard]] const PipelineStats &Stats() const;
+    // Formatted text of the data cells on screen, kept across frames
+    [[nodiscard]] CellTextCache &CellTexts() const;
     // Pipeline steps (we’ll implement next)
     void RebuildIndices() const; // filter + sort -> vm.indices
     void RebuildGroups();  // group -> vm.groups
     void RebuildViewColumns() const;
-    void BuildGroupLevel(int level, int begin, int end, int indent);
+    // After a change of vm.activeSortKeys alone: re-sorts the rows in place
+    // (expanded groups' detail rows now, the others on expand) and keeps the
+    // groups, their summaries and the render list. False, changing nothing,
+    // when the groups must be rebuilt instead (a group column's order changed,
+    // or the pipeline has pending work).
+    bool ResortRows();
+    // Stable sort of a row range by vm.activeSortKeys; false (rows untouched)
+    // when there is no usable sort key
+    bool SortRows(std::vector<int>::iterator first, std::vector<int>::iterator last) const;
+
+  private:
+    mutable std::unique_ptr<ColumnStore> store;
+    mutable std::unique_ptr<FilterProgram> expr;
+    mutable Bitmap selection; // last filter result (valid while hasSelection)
+    mutable bool hasSelection = false;
+    mutable FilterState selectionFilter;     // filter that produced `selection`
+    mutable uint64_t selectionGeneration = 0; // store generation it was evaluated on
+    mutable Bitmap countsBase; // GroupCounts: rows passing countsFilter
+    mutable FilterState countsFilter;
+    mutable uint64_t countsGeneration = 0;
+    mutable bool hasCountsBase = false;
+
+    mutable std::unique_ptr<ThreadPool> workers;
+    mutable std::unique_ptr<CellTextCache> cellTexts;
+    mutable std::shared_ptr<const TrigramIndex> textIndex;
+    mutable std::future<std::shared_ptr<const TrigramIndex>> textIndexBuild;
+
+    // Aggregate states behind vm->groupNodes, formatted on demand
+    mutable std::unique_ptr<GroupSummaries> summaries;
+    void CancelSummaryJob() const;
+
+    std::vector<char> detailSorted; // per group node: detail rows in sort order
+    std::unique_ptr<RollupCache> rollups; // recent groupings, reused by RebuildGroups
+    [[nodiscard]] std::string GroupPath(int groupNodeIndex) const;
+    bool DrillDownFilters(int groupNodeIndex, std::vector<ColumnFilter> &pins,
+                          std::string *why) const;
+
+    mutable std::string findHitsText; // FindNext cache: rows matching findHitsText
+    mutable uint64_t findHitsGeneration = 0;
+    mutable Bitmap findHits;
+    mutable std::string exprText;
+    mutable uint64_t exprGeneration = 0;
 };
 
 } // namespace gird
@@ -2,6 +2,8 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <filesystem>
 
 #ifdef EMSCRIPTEN
@@ -14,6 +16,228 @@ namespace gird {
 // JSON Serialization / Deserialization
 // ============================================================
 
+// Writes a user-entered string (filter text, set members) as a JSON literal
+static void WriteJsonString(std::ostringstream &oss, const std::string &s)
+{
+    oss << '"';
+    for (char c : s)
+    {
+        switch (c)
+        {
+        case '"': oss << "\\\""; break;
+        case '\\': oss << "\\\\"; break;
+        case '\n': oss << "\\n"; break;
+        case '\t': oss << "\\t"; break;
+        default: oss << c; break;
+        }
+    }
+    oss << '"';
+}
+
+static void SkipJsonWs(const std::string &json, size_t &pos)
+{
+    while (pos < json.size() && std::isspace(static_cast<unsigned char>(json[pos])))
+        ++pos;
+}
+
+// Reads a string literal at json[pos]; leaves pos just past the closing quote
+static bool ReadJsonString(const std::string &json, size_t &pos, std::string &out)
+{
+    SkipJsonWs(json, pos);
+    if (pos >= json.size() || json[pos] != '"')
+        return false;
+    out.clear();
+    for (++pos; pos < json.size(); ++pos)
+    {
+        char c = json[pos];
+        if (c == '"')
+        {
+            ++pos;
+            return true;
+        }
+        if (c == '\\' && pos + 1 < json.size())
+        {
+            c = json[++pos];
+            if (c == 'n')
+                c = '\n';
+            else if (c == 't')
+                c = '\t';
+        }
+        out += c;
+    }
+    return false;
+}
+
+// False (no throw) on a malformed or out-of-range number
+static bool ReadJsonInt(const std::string &json, size_t &pos, int &out)
+{
+    SkipJsonWs(json, pos);
+    const char *first = json.data() + pos;
+    const auto [end, ec] = std::from_chars(first, json.data() + json.size(), out);
+    if (ec != std::errc{})
+        return false;
+    pos += static_cast<size_t>(end - first);
+    return true;
+}
+
+// Reads an enum stored as its integer value, rejecting values past `last`
+template <class E> static bool ReadJsonEnum(const std::string &json, size_t &pos, E last, E &out)
+{
+    int v = 0;
+    if (!ReadJsonInt(json, pos, v) || v < 0 || v > static_cast<int>(last))
+        return false;
+    out = static_cast<E>(v);
+    return true;
+}
+
+// Reads [elem,elem,...], calling onElem with pos at each element (it must consume it)
+template <class F> static bool ReadJsonArray(const std::string &json, size_t &pos, F &&onElem)
+{
+    SkipJsonWs(json, pos);
+    if (pos >= json.size() || json[pos] != '[')
+        return false;
+    ++pos;
+    while (true)
+    {
+        SkipJsonWs(json, pos);
+        if (pos >= json.size())
+            return false;
+        if (json[pos] == ']')
+        {
+            ++pos;
+            return true;
+        }
+        if (json[pos] == ',')
+        {
+            ++pos;
+            continue;
+        }
+        if (!onElem(pos))
+            return false;
+    }
+}
+
+// Reads {"key":value,...}, calling onField(key, pos) with pos at the value
+template <class F> static bool ReadJsonObject(const std::string &json, size_t &pos, F &&onField)
+{
+    SkipJsonWs(json, pos);
+    if (pos >= json.size() || json[pos] != '{')
+        return false;
+    ++pos;
+    while (true)
+    {
+        SkipJsonWs(json, pos);
+        if (pos >= json.size())
+            return false;
+        if (json[pos] == '}')
+        {
+            ++pos;
+            return true;
+        }
+        if (json[pos] == ',')
+        {
+            ++pos;
+            continue;
+        }
+        std::string key;
+        if (!ReadJsonString(json, pos, key))
+            return false;
+        SkipJsonWs(json, pos);
+        if (pos >= json.size() || json[pos] != ':')
+            return false;
+        ++pos;
+        if (!onField(key, pos))
+            return false;
+    }
+}
+
+static bool ReadJsonStringArray(const std::string &json, size_t &pos, std::vector<std::string> &out)
+{
+    return ReadJsonArray(json, pos,
+                         [&](size_t &p)
+                         {
+                             std::string s;
+                             if (!ReadJsonString(json, p, s))
+                                 return false;
+                             out.push_back(std::move(s));
+                             return true;
+                         });
+}
+
+static void WriteFilterJson(std::ostringstream &oss, const FilterState &filter)
+{
+    oss << "{\"quickText\":";
+    WriteJsonString(oss, filter.quickText);
+    oss << ",\"combine\":" << (int)filter.combine;
+    oss << ",\"expression\":";
+    WriteJsonString(oss, filter.expression);
+    oss << ",\"columns\":[";
+    for (int i = 0; i < (int)filter.columns.size(); ++i)
+    {
+        const auto &f = filter.columns[i];
+        if (i > 0) oss << ",";
+        oss << "{\"columnId\":";
+        WriteJsonString(oss, f.column_id);
+        oss << ",\"op\":" << (int)f.op << ",\"lo\":";
+        WriteJsonString(oss, f.lo);
+        oss << ",\"hi\":";
+        WriteJsonString(oss, f.hi);
+        oss << ",\"values\":[";
+        for (int v = 0; v < (int)f.values.size(); ++v)
+        {
+            if (v > 0) oss << ",";
+            WriteJsonString(oss, f.values[v]);
+        }
+        oss << "]}";
+    }
+    oss << "]}";
+}
+
+static bool ReadFilterJson(const std::string &json, size_t pos, FilterState &filter)
+{
+    filter = FilterState{};
+    return ReadJsonObject(
+        json, pos,
+        [&](const std::string &key, size_t &p)
+        {
+            if (key == "quickText")
+                return ReadJsonString(json, p, filter.quickText);
+            if (key == "combine")
+                return ReadJsonEnum(json, p, FilterCombine::Any, filter.combine);
+            if (key == "expression")
+                return ReadJsonString(json, p, filter.expression);
+            if (key == "columns")
+            {
+                return ReadJsonArray(
+                    json, p,
+                    [&](size_t &ep)
+                    {
+                        ColumnFilter f;
+                        const bool ok = ReadJsonObject(
+                            json, ep,
+                            [&](const std::string &fk, size_t &fp)
+                            {
+                                if (fk == "columnId")
+                                    return ReadJsonString(json, fp, f.column_id);
+                                if (fk == "op")
+                                    return ReadJsonEnum(json, fp, FilterOp::IsNull, f.op);
+                                if (fk == "lo")
+                                    return ReadJsonString(json, fp, f.lo);
+                                if (fk == "hi")
+                                    return ReadJsonString(json, fp, f.hi);
+                                if (fk == "values")
+                                    return ReadJsonStringArray(json, fp, f.values);
+                                return false;
+                            });
+                        if (ok)
+                            filter.columns.push_back(std::move(f));
+                        return ok;
+                    });
+            }
+            return false;
+        });
+}
+
 std::string GridState::ToJson() const
 {
     // Simple JSON construction (in production, use a proper JSON library)
@@ -40,6 +264,11 @@ std::string GridState::ToJson() const
     }
     oss << "],";
 
+    // Pivot column
+    oss << "\"pivotColumnId\":";
+    WriteJsonString(oss, pivotColumnId);
+    oss << ",";
+
     // Sort keys
     oss << "\"sortKeys\":[";
     for (int i = 0; i < (int)sortKeys.size(); ++i)
@@ -56,14 +285,26 @@ std::string GridState::ToJson() const
     {
         if (i > 0) oss << ",";
         oss << "{\"columnId\":\"" << activeAggs[i].column_id << "\",";
-        oss << "\"type\":" << (int)activeAggs[i].type << "}";
+        oss << "\"type\":" << (int)activeAggs[i].type;
+        if (activeAggs[i].type == AggType::Custom)
+        {
+            oss << ",\"customAggId\":\"" << activeAggs[i].customAggId << "\"";
+            oss << ",\"weightColumnId\":\"" << activeAggs[i].weightColumnId << "\"";
+        }
+        oss << "}";
     }
     oss << "],";
 
+    // Filter
+    oss << "\"filter\":";
+    WriteFilterJson(oss, filter);
+    oss << ",";
+
     // Display preferences
     oss << "\"showDetailRows\":" << (showDetailRows ? "true" : "false") << ",";
     oss << "\"showGrandTotal\":" << (showGrandTotal ? "true" : "false") << ",";
-    oss << "\"showGroupHeaders\":" << (showGroupHeaders ? "true" : "false");
+    oss << "\"showGroupHeaders\":" << (showGroupHeaders ? "true" : "false") << ",";
+    oss << "\"groupsCollapsed\":" << (groupsCollapsed ? "true" : "false");
 
     oss << "}";
     return oss.str();
@@ -130,10 +371,28 @@ bool GridState::FromJson(const std::string &json)
         }
     }
 
-    // Parse showDetailRows, showGrandTotal, showGroupHeaders
+    // Parse pivotColumnId
+    size_t pivotStart = json.find("\"pivotColumnId\":");
+    if (pivotStart != std::string::npos)
+    {
+        size_t pos = json.find(':', pivotStart) + 1;
+        if (!ReadJsonString(json, pos, pivotColumnId))
+            pivotColumnId.clear();
+    }
+
+    // Parse filter
+    size_t filterStart = json.find("\"filter\":{");
+    if (filterStart != std::string::npos)
+    {
+        if (!ReadFilterJson(json, json.find('{', filterStart), filter))
+            filter = FilterState{};
+    }
+
+    // Parse showDetailRows, showGrandTotal, showGroupHeaders, groupsCollapsed
     showDetailRows = (json.find("\"showDetailRows\":true") != std::string::npos);
     showGrandTotal = (json.find("\"showGrandTotal\":true") != std::string::npos);
     showGroupHeaders = (json.find("\"showGroupHeaders\":true") != std::string::npos);
+    groupsCollapsed = (json.find("\"groupsCollapsed\":true") != std::string::npos);
 
     return true;
 }
@@ -264,6 +523,7 @@ GridState ExtractGridState(const GridDocument &doc, const GridViewModel &vm)
 
     // Extract grouping
     state.groupByColumnIds = vm.groupByColumnIds;
+    state.pivotColumnId = vm.pivotColumnId;
 
     // Extract sorting
     state.sortKeys = vm.activeSortKeys;
@@ -271,10 +531,14 @@ GridState ExtractGridState(const GridDocument &doc, const GridViewModel &vm)
     // Extract active aggregations
     state.activeAggs = vm.active_aggs;
 
+    // Extract filter
+    state.filter = doc.filter;
+
     // Extract display preferences
     state.showDetailRows = vm.showDetailRows;
     state.showGrandTotal = vm.showGrandTotal;
     state.showGroupHeaders = vm.showGroupHeaders;
+    state.groupsCollapsed = vm.groupsCollapsed;
 
     return state;
 }
@@ -287,6 +551,7 @@ void ApplyGridState(const GridState &state, GridDocument &doc, GridViewModel &vm
 
     // Apply grouping
     vm.groupByColumnIds = state.groupByColumnIds;
+    vm.pivotColumnId = state.pivotColumnId;
     vm.dirtyGroups = true;
 
     // Apply sorting
@@ -297,10 +562,16 @@ void ApplyGridState(const GridState &state, GridDocument &doc, GridViewModel &vm
     vm.active_aggs = state.activeAggs;
     vm.dirtyViewColumns = true;  // Rebuild view columns to include aggs
 
+    // Apply filter
+    doc.filter = state.filter;
+    vm.dirtyIndices = true;
+
     // Apply display preferences
     vm.showDetailRows = state.showDetailRows;
     vm.showGrandTotal = state.showGrandTotal;
     vm.showGroupHeaders = state.showGroupHeaders;
+    vm.groupsCollapsed = state.groupsCollapsed;
+    vm.toggledGroups.clear();
     vm.dirtyGroups = true;
     vm.dirtyRenderRows = true;
 }
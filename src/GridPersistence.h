@@ -16,17 +16,24 @@ struct GridState
     
     // Grouping: list of column IDs (in order)
     std::vector<std::string> groupByColumnIds;
+
+    // Pivot: column whose values spread the aggregates ("" = off)
+    std::string pivotColumnId;
     
     // Sorting: list of {column_id, direction}
     std::vector<SortKey> sortKeys;
     
     // Aggregation: list of active aggs
     std::vector<AggDef> activeAggs;
+
+    // Filtering: quick text + typed column predicates
+    FilterState filter;
     
     // Display preferences
     bool showDetailRows = true;
     bool showGrandTotal = false;
     bool showGroupHeaders = true;
+    bool groupsCollapsed = false;
     
     // Serialization methods
     std::string ToJson() const;
@@ -1,7 +1,10 @@
 #include "GridViewImGui.h"
+#include "CellCache.h"
+#include "CustomAggregate.h"
 #include "GridFramework.h"
 #include "GridPersistence.h"
 
+#include <algorithm>
 #include <imgui.h>
 
 namespace gird
@@ -21,24 +24,24 @@ struct PresetUIState
     bool presetsNeedRefresh = true;
     bool showSaveSuccess = false;
     bool showLoadSuccess = false;
-    int saveSuccessFrames = 0;
-    int loadSuccessFrames = 0;
+    // ImGui::GetTime() until which the message shows (frames are not paced
+    // under idle rendering)
+    double saveSuccessUntil = 0.0;
+    double loadSuccessUntil = 0.0;
 };
 
 static PresetUIState g_presetUI;
 
-static std::string default_format(const Value &v)
+double TimeUntilUIExpiry()
 {
-    if (auto p = std::get_if<std::string>(&v))
-        return *p;
-    if (auto p = std::get_if<int64_t>(&v))
-        return std::to_string(*p);
-    if (auto p = std::get_if<double>(&v))
-        return std::to_string(*p);
-    if (auto p = std::get_if<bool>(&v))
-        return *p ? "true" : "false";
-    return {};
+    double until = -1.0;
+    if (g_presetUI.showSaveSuccess)
+        until = g_presetUI.saveSuccessUntil;
+    if (g_presetUI.showLoadSuccess && (until < 0.0 || g_presetUI.loadSuccessUntil < until))
+        until = g_presetUI.loadSuccessUntil;
+    return until < 0.0 ? -1.0 : std::max(0.0, until - ImGui::GetTime());
 }
+
 static const char *AggTypeName(gird::AggType t)
 {
     switch (t)
@@ -55,6 +58,14 @@ static const char *AggTypeName(gird::AggType t)
         return "Avg";
     case gird::AggType::Custom:
         return "Custom";
+    case gird::AggType::DistinctCount:
+        return "Distinct";
+    case gird::AggType::Median:
+        return "Median";
+    case gird::AggType::P95:
+        return "P95";
+    case gird::AggType::TopK:
+        return "Top3";
     default:
         return "?";
     }
@@ -63,7 +74,10 @@ static std::string DocKey(const std::string &col_id) { return "doc:" + col_id; }
 
 static std::string AggKey(const gird::AggDef &a)
 {
-    return "agg:" + std::string(AggTypeName(a.type)) + ":" + a.column_id;
+    std::string key = "agg:" + std::string(AggTypeName(a.type)) + ":" + a.column_id;
+    if (a.type == gird::AggType::Custom)
+        key += ":" + a.customAggId + ":" + a.weightColumnId;
+    return key;
 }
 
 
@@ -80,6 +94,7 @@ bool DrawPresetsUI(const GridDocument &doc, GridViewModel &vm, IPersistence *per
     // Refresh preset list periodically
     if (g_presetUI.presetsNeedRefresh)
     {
+        StageTimer timer(vm.pipelineStats, PipelineStage::Persistence);
         g_presetUI.availablePresets = persistence->ListPresets(vm.persistenceKey);
         g_presetUI.presetsNeedRefresh = false;
     }
@@ -109,10 +124,15 @@ bool DrawPresetsUI(const GridDocument &doc, GridViewModel &vm, IPersistence *per
             auto state = ExtractGridState(doc, vm);
             std::string presetKey = vm.persistenceKey + "_" + cleanName;
 
-            if (persistence->Save(presetKey, state))
+            bool saved = false;
+            {
+                StageTimer timer(vm.pipelineStats, PipelineStage::Persistence);
+                saved = persistence->Save(presetKey, state);
+            }
+            if (saved)
             {
                 g_presetUI.showSaveSuccess = true;
-                g_presetUI.saveSuccessFrames = 120;  // Show for 2 seconds at 60 FPS
+                g_presetUI.saveSuccessUntil = ImGui::GetTime() + 2.0;
                 g_presetUI.presetsNeedRefresh = true;
                 g_presetUI.savePresetNameBuffer[0] = '\0';
                 changed = true;
@@ -126,8 +146,7 @@ bool DrawPresetsUI(const GridDocument &doc, GridViewModel &vm, IPersistence *per
         ImGui::SameLine();
         ImGui::TextColored(ImVec4(0.2f, 0.8f, 0.2f, 1.0f), "✓ Saved!");
 
-        g_presetUI.saveSuccessFrames--;
-        if (g_presetUI.saveSuccessFrames <= 0)
+        if (ImGui::GetTime() >= g_presetUI.saveSuccessUntil)
             g_presetUI.showSaveSuccess = false;
     }
 
@@ -172,11 +191,16 @@ bool DrawPresetsUI(const GridDocument &doc, GridViewModel &vm, IPersistence *per
         std::string presetKey = vm.persistenceKey + "_" + g_presetUI.loadPresetName;
         GridState state;
 
-        if (persistence->Load(presetKey, state))
+        bool loaded = false;
+        {
+            StageTimer timer(vm.pipelineStats, PipelineStage::Persistence);
+            loaded = persistence->Load(presetKey, state);
+        }
+        if (loaded)
         {
             ApplyGridState(state, const_cast<GridDocument&>(doc), vm);
             g_presetUI.showLoadSuccess = true;
-            g_presetUI.loadSuccessFrames = 120;
+            g_presetUI.loadSuccessUntil = ImGui::GetTime() + 2.0;
             changed = true;
         }
     }
@@ -187,8 +211,7 @@ bool DrawPresetsUI(const GridDocument &doc, GridViewModel &vm, IPersistence *per
         ImGui::SameLine();
         ImGui::TextColored(ImVec4(0.2f, 0.8f, 0.2f, 1.0f), "✓ Loaded!");
 
-        g_presetUI.loadSuccessFrames--;
-        if (g_presetUI.loadSuccessFrames <= 0)
+        if (ImGui::GetTime() >= g_presetUI.loadSuccessUntil)
             g_presetUI.showLoadSuccess = false;
     }
 
@@ -197,7 +220,10 @@ bool DrawPresetsUI(const GridDocument &doc, GridViewModel &vm, IPersistence *per
     if (ImGui::Button("Delete##btn") && !g_presetUI.loadPresetName.empty())
     {
         std::string presetKey = vm.persistenceKey + "_" + g_presetUI.loadPresetName;
-        persistence->Clear(presetKey);
+        {
+            StageTimer timer(vm.pipelineStats, PipelineStage::Persistence);
+            persistence->Clear(presetKey);
+        }
         g_presetUI.presetsNeedRefresh = true;
         g_presetUI.loadPresetName = "";
         changed = true;
@@ -237,6 +263,17 @@ static bool DrawGroupingConfig(const gird::GridDocument &doc, gird::GridViewMode
         vm.dirtyGroups = true;
         vm.dirtyRenderRows = true;
     }
+    ImGui::SameLine();
+
+    // Default expand state of groups; resets the per-group toggles
+    if (ImGui::Checkbox("Collapsed", &vm.groupsCollapsed))
+    {
+        vm.toggledGroups.clear();
+        vm.dirtyGroups = true;
+        vm.dirtyRenderRows = true;
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Timings", &vm.showPipelineStats);
 
     ImGui::SameLine();
     if (ImGui::Button("Grouping..."))
@@ -380,6 +417,33 @@ static bool DrawGroupingConfig(const gird::GridDocument &doc, gird::GridViewMode
         ImGui::EndPopup();
     }
 
+    // Pivot: grouped aggregates spread into one column per value of another column
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(160.0f);
+    if (ImGui::BeginCombo("Pivot by", label_for_id(vm.pivotColumnId)))
+    {
+        if (ImGui::Selectable("(none)", vm.pivotColumnId.empty()))
+        {
+            vm.pivotColumnId.clear();
+            changed = true;
+        }
+        for (int c : groupable)
+        {
+            const bool selected = (doc.columns[c].id == vm.pivotColumnId);
+            if (ImGui::Selectable(doc.columns[c].label.c_str(), selected))
+            {
+                vm.pivotColumnId = doc.columns[c].id;
+                changed = true;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    if (vm.pivotDropped > 0)
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(%d values past the column limit not shown)", vm.pivotDropped);
+    }
+
     ImGui::TextUnformatted("Aggregate columns:");
     ImGui::Separator();
 
@@ -440,7 +504,7 @@ static bool DrawGroupingConfig(const gird::GridDocument &doc, gird::GridViewMode
         const char *preview_agg = AggTypeName(a.type);
         if (ImGui::BeginCombo("##aggFn", preview_agg))
         {
-            for (int t = static_cast<int>(gird::AggType::Count); t <= static_cast<int>(gird::AggType::Custom); ++t)
+            for (int t = static_cast<int>(gird::AggType::Count); t <= static_cast<int>(gird::AggType::TopK); ++t)
             {
                 auto at = static_cast<gird::AggType>(t);
                 bool sel = (a.type == at);
@@ -453,6 +517,45 @@ static bool DrawGroupingConfig(const gird::GridDocument &doc, gird::GridViewMode
             ImGui::EndCombo();
         }
 
+        // Custom: pick the registered aggregator, and its weight column if it takes one
+        if (a.type == gird::AggType::Custom)
+        {
+            const gird::CustomAggregator *custom = gird::FindCustomAggregate(doc, a.customAggId);
+            ImGui::SameLine();
+            if (ImGui::BeginCombo("##aggCustom", custom ? custom->Label().c_str() : "(aggregator)"))
+            {
+                for (const auto &agg : doc.customAggs)
+                    if (ImGui::Selectable(agg->Label().c_str(), agg.get() == custom))
+                    {
+                        a.customAggId = agg->Id();
+                        changed = true;
+                    }
+                ImGui::EndCombo();
+            }
+            if (custom && custom->Weighted())
+            {
+                const char *preview_weight = "(weight)";
+                for (auto &c : doc.columns)
+                    if (c.id == a.weightColumnId)
+                        preview_weight = c.label.c_str();
+                ImGui::SameLine();
+                if (ImGui::BeginCombo("##aggWeight", preview_weight))
+                {
+                    for (const auto &col : doc.columns)
+                    {
+                        if (col.type != gird::ValueType::Int64 && col.type != gird::ValueType::Double)
+                            continue;
+                        if (ImGui::Selectable(col.label.c_str(), col.id == a.weightColumnId))
+                        {
+                            a.weightColumnId = col.id;
+                            changed = true;
+                        }
+                    }
+                    ImGui::EndCombo();
+                }
+            }
+        }
+
         ImGui::SameLine();
         if (ImGui::Button("Delete"))
         {
@@ -478,8 +581,10 @@ static bool DrawGroupingConfig(const gird::GridDocument &doc, gird::GridViewMode
 
     for (int i = 0; i < static_cast<int>(vm.viewColumns.size()); ++i)
     {
-        ImGui::PushID(i);
         const auto &vc = vm.viewColumns[i];
+        if (vc.pivotKey >= 0)
+            continue; // pivot cells show and hide with their aggregate column
+        ImGui::PushID(i);
 
         // Determine label + stable key
         std::string key;
@@ -568,6 +673,242 @@ static bool DrawGroupingConfig(const gird::GridDocument &doc, gird::GridViewMode
     return changed;
 }
 
+static const char *FilterOpName(FilterOp op)
+{
+    static const char *names[] = {"Range", "In", "Is null"};
+    return names[static_cast<int>(op)];
+}
+
+static std::string JoinValues(const std::vector<std::string> &values)
+{
+    std::string out;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (i > 0)
+            out += ",";
+        out += values[i];
+    }
+    return out;
+}
+
+static std::vector<std::string> SplitValues(const char *text)
+{
+    std::vector<std::string> out;
+    std::string cur;
+    for (const char *p = text;; ++p)
+    {
+        if (*p == ',' || *p == '\0')
+        {
+            const size_t b = cur.find_first_not_of(' ');
+            const size_t e = cur.find_last_not_of(' ');
+            if (b != std::string::npos)
+                out.push_back(cur.substr(b, e - b + 1));
+            cur.clear();
+            if (*p == '\0')
+                break;
+        }
+        else
+        {
+            cur += *p;
+        }
+    }
+    return out;
+}
+
+static bool DrawFilterConfig(gird::GridDocument &doc, const GridController &ctl)
+{
+    bool changed = false;
+    FilterState &f = doc.filter;
+
+    ImGui::TextUnformatted("Column filters:");
+    ImGui::SameLine();
+    const char *combineNames[] = {"Match all", "Match any"};
+    ImGui::SetNextItemWidth(120.0f);
+    if (ImGui::BeginCombo("##filterCombine", combineNames[static_cast<int>(f.combine)]))
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            if (ImGui::Selectable(combineNames[i], static_cast<int>(f.combine) == i))
+            {
+                f.combine = static_cast<FilterCombine>(i);
+                changed = true;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::Separator();
+
+    for (int i = 0; i < static_cast<int>(f.columns.size()); ++i)
+    {
+        ImGui::PushID(i);
+        auto &cf = f.columns[i];
+
+        const char *preview_col = "(none)";
+        for (auto &c : doc.columns)
+            if (c.id == cf.column_id)
+            {
+                preview_col = c.label.c_str();
+                break;
+            }
+
+        ImGui::SetNextItemWidth(180.0f);
+        if (ImGui::BeginCombo("##filterCol", preview_col))
+        {
+            for (const auto &col : doc.columns)
+            {
+                if (ImGui::Selectable(col.label.c_str(), col.id == cf.column_id))
+                {
+                    cf.column_id = col.id;
+                    changed = true;
+                }
+            }
+            ImGui::EndCombo();
+        }
+
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(80.0f);
+        if (ImGui::BeginCombo("##filterOp", FilterOpName(cf.op)))
+        {
+            for (FilterOp op : {FilterOp::Range, FilterOp::In, FilterOp::IsNull})
+            {
+                if (ImGui::Selectable(FilterOpName(op), cf.op == op))
+                {
+                    cf.op = op;
+                    changed = true;
+                }
+            }
+            ImGui::EndCombo();
+        }
+
+        ImGui::SameLine();
+        if (cf.op == FilterOp::Range)
+        {
+            char lo[64], hi[64];
+            snprintf(lo, sizeof(lo), "%s", cf.lo.c_str());
+            snprintf(hi, sizeof(hi), "%s", cf.hi.c_str());
+            ImGui::SetNextItemWidth(110.0f);
+            if (ImGui::InputText("##lo", lo, sizeof(lo)))
+            {
+                cf.lo = lo;
+                changed = true;
+            }
+            ImGui::SameLine();
+            ImGui::TextUnformatted("..");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(110.0f);
+            if (ImGui::InputText("##hi", hi, sizeof(hi)))
+            {
+                cf.hi = hi;
+                changed = true;
+            }
+        }
+        else if (cf.op == FilterOp::In)
+        {
+            char values[512];
+            snprintf(values, sizeof(values), "%s", JoinValues(cf.values).c_str());
+            ImGui::SetNextItemWidth(240.0f);
+            if (ImGui::InputText("##values", values, sizeof(values)))
+            {
+                cf.values = SplitValues(values);
+                changed = true;
+            }
+
+            // Indexed columns: pick members from the value list (counts come
+            // from bitmap index cardinalities, so this never scans rows)
+            const ColumnDef *def = ctl.FindCol(cf.column_id);
+            if (def && def->groupable)
+            {
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(30.0f);
+                if (ImGui::BeginCombo("##pick", "", ImGuiComboFlags_HeightLarge))
+                {
+                    for (const auto &vc : ctl.GroupCounts(cf.column_id))
+                    {
+                        auto it = std::find(cf.values.begin(), cf.values.end(), vc.label);
+                        const bool member = it != cf.values.end();
+                        const std::string item = vc.label + "  (" + std::to_string(vc.count) + ")";
+                        if (ImGui::Selectable(item.c_str(), member))
+                        {
+                            if (member)
+                                cf.values.erase(it);
+                            else
+                                cf.values.push_back(vc.label);
+                            changed = true;
+                        }
+                    }
+                    ImGui::EndCombo();
+                }
+            }
+        }
+
+        ImGui::SameLine();
+        if (ImGui::Button("Remove"))
+        {
+            f.columns.erase(f.columns.begin() + i);
+            changed = true;
+            ImGui::PopID();
+            break;
+        }
+
+        ImGui::PopID();
+    }
+
+    if (ImGui::Button("Add filter"))
+    {
+        f.columns.push_back(ColumnFilter{});
+        changed = true;
+    }
+
+    return changed;
+}
+
+// Stage timings of the last runs (rolling window) and the sizes they ran over
+static void DrawPipelineStats(const PipelineStats &stats, bool *open)
+{
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    if (!ImGui::Begin("Pipeline timings", open, ImGuiWindowFlags_AlwaysAutoResize))
+    {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("Rows %d of %d, groups %d, render rows %d", stats.rows, stats.sourceRows, stats.groups,
+                stats.renderRows);
+    if (ImGui::BeginTable("##timings", 6, ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Stage");
+        ImGui::TableSetupColumn("Runs");
+        ImGui::TableSetupColumn("Last ms");
+        ImGui::TableSetupColumn("p50 ms");
+        ImGui::TableSetupColumn("p95 ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < static_cast<int>(PipelineStage::Count); ++i)
+        {
+            const PipelineStage stage = static_cast<PipelineStage>(i);
+            const StageTimes::Summary t = stats[stage].Summarize();
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(StageName(stage));
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(t.runs));
+            if (t.samples == 0)
+                continue;
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", t.lastMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", t.p50Ms);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", t.p95Ms);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", t.maxMs);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::TextDisabled("Percentiles over the last %d runs of each stage", StageTimes::Window);
+    ImGui::End();
+}
+
 void DrawGridImGui(GridDocument &doc, GridViewModel &vm, GridController &ctl, ImVec2 size)
 {
     ctl.doc = &doc;
@@ -590,6 +931,59 @@ void DrawGridImGui(GridDocument &doc, GridViewModel &vm, GridController &ctl, Im
             vm.dirtyRenderRows = true;
         }
         ImGui::Separator();
+        if (DrawFilterConfig(doc, ctl))
+            vm.dirtyIndices = true;
+        ImGui::Separator();
+    }
+
+    // Quick filter (the InputText keeps its own buffer while being edited)
+    {
+        char quick[256];
+        snprintf(quick, sizeof(quick), "%s", doc.filter.quickText.c_str());
+        if (ImGui::InputText("Filter", quick, sizeof(quick)))
+        {
+            doc.filter.quickText = quick;
+            vm.dirtyIndices = true;
+        }
+
+        char expression[512];
+        snprintf(expression, sizeof(expression), "%s", doc.filter.expression.c_str());
+        if (ImGui::InputText("Expression", expression, sizeof(expression)))
+        {
+            doc.filter.expression = expression;
+            vm.dirtyIndices = true;
+        }
+        if (!vm.filterError.empty())
+        {
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(0.9f, 0.3f, 0.3f, 1.0f), "%s", vm.filterError.c_str());
+        }
+
+        // Find: jumps to the next matching row in view order (Enter, Next or F3)
+        char find[256];
+        snprintf(find, sizeof(find), "%s", vm.findText.c_str());
+        bool next = ImGui::InputText("Find", find, sizeof(find),
+                                     ImGuiInputTextFlags_EnterReturnsTrue);
+        vm.findText = find;
+        ImGui::SameLine();
+        next |= ImGui::Button("Next");
+        next |= !vm.findText.empty() && ImGui::IsKeyPressed(ImGuiKey_F3);
+        if (next)
+        {
+            vm.findRenderRow = ctl.FindNext(vm.findText, vm.findRenderRow);
+            vm.scrollToFind = vm.findRenderRow >= 0;
+        }
+        if (next && vm.findRenderRow < 0)
+        {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(no match)");
+        }
+
+        if (const FilterStats &fs = vm.filterStats; fs.blocks > 0)
+            ImGui::TextDisabled("Zone maps: %.0f%% of blocks not scanned (%d skipped, %d taken whole, "
+                                "%d scanned)",
+                                fs.SkipRatio() * 100.0, fs.skipped, fs.accepted,
+                                fs.blocks - fs.skipped - fs.accepted);
     }
 
     ImGui::Separator();
@@ -660,7 +1054,27 @@ void DrawGridImGui(GridDocument &doc, GridViewModel &vm, GridController &ctl, Im
             ImGui::TableSetupColumn(label, cflags, 100.0f, static_cast<ImGuiID>(vc));
         }
 
-        ImGui::TableHeadersRow();
+        // Header row by hand so aggregate columns can explain their error bounds
+        ImGui::TableNextRow(ImGuiTableRowFlags_Headers);
+
+        // Columns on screen (enabled and not scrolled out of view, as laid out
+        // by the row above): rows only visit these, so a frame costs the cells
+        // actually shown rather than rows x view columns
+        std::vector<int> onScreen;
+        onScreen.reserve(colCount);
+        for (int vc = 0; vc < colCount; ++vc)
+            if (ImGui::TableGetColumnFlags(vc) & ImGuiTableColumnFlags_IsVisible)
+                onScreen.push_back(vc);
+
+        for (int vc : onScreen)
+        {
+            ImGui::TableSetColumnIndex(vc);
+            ImGui::PushID(vc);
+            ImGui::TableHeader(ImGui::TableGetColumnName(vc));
+            ImGui::PopID();
+            if (!vm.viewColumns[vc].tooltip.empty() && ImGui::IsItemHovered())
+                ImGui::SetTooltip("%s", vm.viewColumns[vc].tooltip.c_str());
+        }
 
         // ----- Read ImGui sort specs -> vm.active_sort_keys -----
         if (ImGuiTableSortSpecs *sortSpecs = ImGui::TableGetSortSpecs())
@@ -693,7 +1107,9 @@ void DrawGridImGui(GridDocument &doc, GridViewModel &vm, GridController &ctl, Im
                     vm.activeSortKeys.push_back(std::move(key));
                 }
 
-                vm.dirtyIndices = true;
+                // A new order alone keeps the filtered rows and the groups
+                if (!ctl.ResortRows())
+                    vm.dirtyIndices = true;
                 sortSpecs->SpecsDirty = false;
             }
         }
@@ -713,14 +1129,43 @@ void DrawGridImGui(GridDocument &doc, GridViewModel &vm, GridController &ctl, Im
         }
 
         // ----- Draw rows from vm.render_rows -----
+        StageTimer drawTimer(vm.pipelineStats, PipelineStage::Draw);
         ImGuiListClipper clipper;
-        clipper.Begin(static_cast<int>(vm.renderRows.size()));
+        clipper.Begin(vm.renderRows.Size());
+
+        // Lay out the find hit this frame even if off screen, so it can scroll to itself
+        const bool scrollToFind = vm.scrollToFind && vm.findRenderRow >= 0 &&
+                                  vm.findRenderRow < vm.renderRows.Size();
+        if (scrollToFind)
+            clipper.IncludeItemByIndex(vm.findRenderRow);
+        vm.scrollToFind = false;
+
+        // Data cells are formatted and styled once and reused until their row changes
+        CellTextCache &cellText = ctl.CellTexts();
+        cellText.BeginFrame(doc);
+        std::vector<int> onScreenDocCols;
+        for (int vc : onScreen)
+            if (vm.viewColumns[vc].kind == ViewColumn::Kind::Doc)
+                onScreenDocCols.push_back(vm.viewColumns[vc].docColIndex);
+        std::vector<int> windowRows;
 
         while (clipper.Step())
         {
+            // Group summaries are formatted on first display, a screen ahead either way
+            constexpr int SummaryPrefetchRows = 64;
+            ctl.EnsureSummaries(clipper.DisplayStart - SummaryPrefetchRows,
+                                clipper.DisplayEnd + SummaryPrefetchRows);
+
+            // Missing cells of this window: formatted and styled a column at a time
+            windowRows.clear();
+            for (int rr = clipper.DisplayStart; rr < clipper.DisplayEnd; ++rr)
+                if (const RenderRow r = vm.renderRows.At(rr); r.kind == RenderRowKind::DataRow)
+                    windowRows.push_back(r.srcRrowIndex);
+            cellText.Prepare(doc, windowRows, onScreenDocCols);
+
             for (int rr = clipper.DisplayStart; rr < clipper.DisplayEnd; ++rr)
             {
-                const RenderRow &r = vm.renderRows[rr];
+                const RenderRow r = vm.renderRows.At(rr);
                 ImGui::TableNextRow();
 
                 if (r.kind == RenderRowKind::GroupHeader)
@@ -732,19 +1177,43 @@ void DrawGridImGui(GridDocument &doc, GridViewModel &vm, GridController &ctl, Im
 
                     ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, IM_COL32(45, 45, 70, 255));
 
-                    for (int vc = 0; vc < colCount; ++vc)
+                    for (int vc : onScreen)
                     {
                         ImGui::TableSetColumnIndex(vc);
 
                         if (vc == 0)
                         {
                             ImGui::Indent(static_cast<float>(g.indent) * 16.0f);
+                            if (vm.renderRows.Collapsible(r.groupNodeIndex))
+                            {
+                                const bool open = vm.renderRows.Expanded(r.groupNodeIndex);
+                                ImGui::PushID(r.groupNodeIndex);
+                                if (ImGui::ArrowButton("##toggle", open ? ImGuiDir_Down : ImGuiDir_Right))
+                                    ctl.SetGroupExpanded(r.groupNodeIndex, !open);
+                                ImGui::PopID();
+                                ImGui::SameLine();
+                            }
                             ImGui::TextUnformatted(g.label.c_str());
                             ImGui::Unindent(static_cast<float>(g.indent) * 16.0f);
+
+                            // Double-click a group label to drill into it
+                            if (!g.columnId.empty() && ImGui::IsItemHovered())
+                            {
+                                std::string why;
+                                if (!ctl.CanDrillDown(r.groupNodeIndex, &why))
+                                    ImGui::SetTooltip("%s", why.c_str());
+                                else if (ImGui::IsMouseDoubleClicked(0))
+                                    ctl.DrillDown(r.groupNodeIndex);
+                            }
                         }
                         else
                         {
-                            if (vc < static_cast<int>(g.summaryByCol.size()) && !g.summaryByCol[vc].empty())
+                            if (!g.summaryReady)
+                            {
+                                if (vm.viewColumns[vc].kind == ViewColumn::Kind::Agg)
+                                    ImGui::TextDisabled("...");
+                            }
+                            else if (vc < static_cast<int>(g.summaryByCol.size()) && !g.summaryByCol[vc].empty())
                                 ImGui::TextUnformatted(g.summaryByCol[vc].c_str());
                         }
                     }
@@ -752,9 +1221,15 @@ void DrawGridImGui(GridDocument &doc, GridViewModel &vm, GridController &ctl, Im
                 else // DataRow
                 {
                     const int src_row_idx = r.srcRrowIndex;
-                    const auto &row = doc.source->RowAt(src_row_idx);
 
-                    for (int vc = 0; vc < colCount; ++vc)
+                    if (rr == vm.findRenderRow)
+                    {
+                        ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1, IM_COL32(110, 90, 30, 255));
+                        if (scrollToFind)
+                            ImGui::SetScrollHereY(0.5f);
+                    }
+
+                    for (int vc : onScreen)
                     {
                         ImGui::TableSetColumnIndex(vc);
 
@@ -765,10 +1240,14 @@ void DrawGridImGui(GridDocument &doc, GridViewModel &vm, GridController &ctl, Im
 
                         if (vcol.kind == ViewColumn::Kind::Doc)
                         {
-                            const auto &col = doc.columns[vcol.docColIndex];
-                            Value v = col.getValue ? col.getValue(row) : Value(std::string{});
-                            const auto text = col.format ? col.format(v) : default_format(v);
-                            ImGui::TextUnformatted(text.c_str());
+                            const CellTextCache::Cell cell = cellText.Get(doc, src_row_idx, vcol.docColIndex);
+                            if (cell.bg)
+                                ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, cell.bg);
+                            if (cell.color)
+                                ImGui::PushStyleColor(ImGuiCol_Text, cell.color);
+                            ImGui::TextUnformatted(cell.text.data(), cell.text.data() + cell.text.size());
+                            if (cell.color)
+                                ImGui::PopStyleColor();
                         }
                         else
                         {
@@ -785,6 +1264,9 @@ void DrawGridImGui(GridDocument &doc, GridViewModel &vm, GridController &ctl, Im
 
         ImGui::EndTable();
     }
+
+    if (vm.showPipelineStats)
+        DrawPipelineStats(ctl.Stats(), &vm.showPipelineStats);
 }
 
 
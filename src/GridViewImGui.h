@@ -7,4 +7,9 @@ namespace gird {
         struct GridController;
 
         void DrawGridImGui(GridDocument& doc, GridViewModel& vm, GridController& ctl, ImVec2 size);
+
+        // Seconds until a timed message (preset "Saved!"/"Loaded!") is due to
+        // disappear, so an event loop blocking while idle can wake to redraw it;
+        // negative when none is showing, 0 when one is already due.
+        double TimeUntilUIExpiry();
 }
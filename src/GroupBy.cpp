@@ -0,0 +1,273 @@
+#include "GroupBy.h"
+#include "ColumnStore.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <unordered_map>
+
+namespace gird
+{
+
+GroupKeys::GroupKeys(const GridDocument &doc, ColumnStore &store, int docCol)
+    : docCol(docCol), def(&doc.columns[docCol])
+{
+    if (def->typedGroupKey)
+    {
+        col = &store.Column(docCol);
+        if (def->groupBucket > 0)
+            perBucket = 1.0 / def->groupBucket;
+    }
+}
+
+int64_t GroupKeys::KeyOf(const GridDocument &doc, int row)
+{
+    if (!col)
+    {
+        std::string key = GridController::GetGroupKey(doc, docCol, doc.source->RowAt(row));
+        return ids.try_emplace(std::move(key), static_cast<int64_t>(ids.size())).first->second;
+    }
+    if (col->nullCount > 0 && col->nulls.Test(row))
+        return NullKey;
+
+    switch (col->type)
+    {
+    case ValueType::Int64:
+    case ValueType::Bool:
+        return col->i64[row];
+    case ValueType::Date:
+        return col->days[row];
+    case ValueType::Double:
+    {
+        const double q = std::round(col->f64[row] * perBucket);
+        if (std::fabs(q) < 9.0e18)
+            return static_cast<int64_t>(q);
+        return q > 0 ? std::numeric_limits<int64_t>::max() : NullKey + 1; // huge / NaN
+    }
+    case ValueType::String:
+    default:
+        return col->codes[row];
+    }
+}
+
+int GroupKeys::Compare(const GridDocument &doc, int64_t a, int rowA, int64_t b, int rowB) const
+{
+    if (!col)
+        return GridController::CompareValues(def->type, def->getValue(doc.source->RowAt(rowA)),
+                                             def->getValue(doc.source->RowAt(rowB)));
+    if (a == b)
+        return 0;
+    if (col->type == ValueType::String && a != NullKey && b != NullKey)
+        return col->dict[a].compare(col->dict[b]);
+    return a < b ? -1 : 1;
+}
+
+namespace
+{
+
+// Rows per aggregation task: big enough to amortize a task, small enough that
+// one large group still spreads over every core
+constexpr int AggTaskRows = 1 << 15;
+
+} // namespace
+
+void ArrangeGroups(const GridDocument &doc, const std::vector<GroupKeys> &keys,
+                   const std::vector<GroupByLevel> &levels, std::vector<GroupByNode> &created,
+                   const std::vector<int> &leafOf, std::vector<int> &rows, std::vector<GroupByNode> &nodes)
+{
+    nodes.clear();
+    const int lastLevel = static_cast<int>(levels.size()) - 1;
+
+    // ---- Order the groups only: children by key, per level direction ----
+    std::vector<std::vector<int>> children(created.size());
+    std::vector<int> roots;
+    for (int n = 0; n < static_cast<int>(created.size()); ++n)
+        (created[n].parent < 0 ? roots : children[created[n].parent]).push_back(n);
+
+    auto byKey = [&](std::vector<int> &list)
+    {
+        if (list.size() < 2)
+            return;
+        const int level = created[list[0]].level;
+        const GroupKeys &k = keys[level];
+        if (!k.Ordered())
+            return;
+        const bool descending = levels[level].descending;
+        std::sort(list.begin(), list.end(),
+                  [&](int a, int b)
+                  {
+                      const int c = k.Compare(doc, created[a].key, created[a].keyRow, created[b].key,
+                                              created[b].keyRow);
+                      return descending ? c > 0 : c < 0;
+                  });
+    };
+    byKey(roots);
+    for (auto &list : children)
+        byKey(list);
+
+    // ---- Preorder: assign row ranges (leaves consecutive) and renumber ----
+    nodes.reserve(created.size());
+    std::vector<int> order(created.size()); // created index -> preorder index
+    int cursor = 0;
+    auto visit = [&](auto &self, int n, int parent) -> void
+    {
+        const int at = static_cast<int>(nodes.size());
+        order[n] = at;
+        const int count = created[n].end;
+        nodes.push_back(std::move(created[n]));
+        nodes[at].parent = parent;
+        nodes[at].begin = cursor;
+        if (nodes[at].level == lastLevel)
+            cursor += count;
+        for (int c : children[n])
+            self(self, c, at);
+        nodes[at].end = cursor;
+    };
+    for (int n : roots)
+        visit(visit, n, -1);
+
+    // ---- Stable scatter: each leaf's rows land in its range, in input order ----
+    std::vector<int> fill(nodes.size());
+    for (size_t n = 0; n < nodes.size(); ++n)
+        fill[n] = nodes[n].begin;
+    std::vector<int> grouped(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+        grouped[fill[order[leafOf[i]]]++] = rows[i];
+    rows.swap(grouped);
+}
+
+void RollUpGroups(const AggPlan &aggs, std::vector<GroupByNode> &nodes)
+{
+    // Preorder puts every child after its parent, so walking backwards folds
+    // each child in before its parent is itself merged upwards.
+    for (int n = static_cast<int>(nodes.size()) - 1; n >= 0; --n)
+        if (const int p = nodes[n].parent; p >= 0)
+            aggs.Merge(nodes[n].aggs.data(), nodes[n].sketches.data(), nodes[n].customs.data(),
+                       nodes[p].aggs.data(), nodes[p].sketches.data(), nodes[p].customs.data());
+}
+
+void HashGroupBy(const GridDocument &doc, ColumnStore &store,
+                 const std::vector<GroupByLevel> &levels,
+                 const AggPlan &aggs, ThreadPool &pool, std::vector<int> &rows,
+                 std::vector<GroupByNode> &nodes)
+{
+    nodes.clear();
+    if (levels.empty())
+        return;
+
+    std::vector<GroupKeys> keys;
+    keys.reserve(levels.size());
+    for (const GroupByLevel &level : levels)
+        keys.emplace_back(doc, store, level.docCol);
+
+    // ---- One pass: row -> group at every level ----
+    std::vector<GroupByNode> created;
+    std::unordered_map<GroupSlot, int, GroupSlotHash> nodeOf;
+    std::vector<int> leafOf(rows.size());
+    const int lastLevel = static_cast<int>(levels.size()) - 1;
+
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        const int r = rows[i];
+        int node = -1;
+        for (int l = 0; l <= lastLevel; ++l)
+        {
+            const int64_t key = keys[l].KeyOf(doc, r);
+            auto [it, inserted] = nodeOf.try_emplace(GroupSlot{node, key}, static_cast<int>(created.size()));
+            if (inserted)
+            {
+                GroupByNode g;
+                g.parent = node;
+                g.level = l;
+                g.key = key;
+                g.keyRow = r;
+                g.aggs.resize(aggs.Slots());
+                g.sketches.resize(aggs.SketchSlots());
+                g.customs.resize(aggs.CustomSlots());
+                created.push_back(std::move(g));
+            }
+            node = it->second;
+        }
+
+        ++created[node].end; // leaf row count until ranges are assigned
+        leafOf[i] = node;
+    }
+
+    ArrangeGroups(doc, keys, levels, created, leafOf, rows, nodes);
+
+    // ---- Aggregates: each leaf over its contiguous rows, then rolled up ----
+    // A task is either a run of whole leaves (into their own states) or one
+    // slice of a large leaf (into its own partial states).
+    struct AggTask
+    {
+        int first = 0, last = 0; // leaf nodes [first, last), or the sliced leaf
+        int begin = 0, end = 0;  // slice rows; partial >= 0 only
+        int partial = -1;
+    };
+    std::vector<AggTask> tasks;
+    int sliced = 0;
+    for (int n = 0; n < static_cast<int>(nodes.size()); ++n)
+    {
+        const GroupByNode &g = nodes[n];
+        if (g.level != lastLevel)
+            continue;
+        const int count = g.end - g.begin;
+        if (count > AggTaskRows)
+        {
+            for (int b = g.begin; b < g.end; b += AggTaskRows)
+                tasks.push_back({n, n + 1, b, std::min(b + AggTaskRows, g.end), sliced++});
+            continue;
+        }
+        // Extend the open run while it stays within one task's rows
+        if (!tasks.empty() && tasks.back().partial < 0 &&
+            tasks.back().end - tasks.back().begin + count <= AggTaskRows)
+        {
+            tasks.back().last = n + 1;
+            tasks.back().end = g.end;
+        }
+        else
+            tasks.push_back({n, n + 1, g.begin, g.end, -1});
+    }
+
+    const size_t slots = aggs.Slots();
+    const size_t sketchSlots = aggs.SketchSlots();
+    const size_t customSlots = aggs.CustomSlots();
+    std::vector<AggState> partials(sliced * slots);
+    std::vector<SketchState> partialSketches(sliced * sketchSlots);
+    std::vector<CustomState> partialCustoms(sliced * customSlots);
+    pool.ParallelFor(static_cast<int>(tasks.size()),
+                     [&](int t)
+                     {
+                         const AggTask &task = tasks[t];
+                         if (task.partial >= 0)
+                         {
+                             aggs.Accumulate(rows.data() + task.begin, task.end - task.begin,
+                                             partials.data() + task.partial * slots,
+                                             partialSketches.data() + task.partial * sketchSlots,
+                                             partialCustoms.data() + task.partial * customSlots);
+                             return;
+                         }
+                         for (int n = task.first; n < task.last; ++n)
+                         {
+                             GroupByNode &g = nodes[n];
+                             if (g.level == lastLevel)
+                                 aggs.Accumulate(rows.data() + g.begin, g.end - g.begin, g.aggs.data(),
+                                                 g.sketches.data(), g.customs.data());
+                         }
+                     });
+    for (const AggTask &task : tasks)
+        if (task.partial >= 0)
+        {
+            GroupByNode &g = nodes[task.first];
+            aggs.Merge(partials.data() + task.partial * slots,
+                       partialSketches.data() + task.partial * sketchSlots,
+                       partialCustoms.data() + task.partial * customSlots, g.aggs.data(),
+                       g.sketches.data(), g.customs.data());
+        }
+
+    RollUpGroups(aggs, nodes);
+}
+
+} // namespace gird
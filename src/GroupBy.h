@@ -0,0 +1,112 @@
+#pragma once
+#include "Aggregate.h"
+#include "GridFramework.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gird
+{
+
+class ColumnStore;
+class ThreadPool;
+struct TypedColumn;
+
+// ---- Group keys of one column ----
+// An integer key per row: typed-key columns read it straight from the column
+// store (see ColumnDef::typedGroupKey), others intern their getGroupKey text.
+// Keys order like the column values (strings by dictionary text, nulls first).
+class GroupKeys
+{
+  public:
+    static constexpr int64_t NullKey = std::numeric_limits<int64_t>::min();
+
+    GroupKeys(const GridDocument &doc, ColumnStore &store, int docCol);
+
+    [[nodiscard]] int64_t KeyOf(const GridDocument &doc, int row);
+    // Interned keys compare the column values of a row holding each key.
+    [[nodiscard]] int Compare(const GridDocument &doc, int64_t a, int rowA, int64_t b, int rowB) const;
+    // False for interned keys of a column without getValue (no order).
+    [[nodiscard]] bool Ordered() const { return col || def->getValue; }
+
+  private:
+    int docCol = -1;
+    const ColumnDef *def = nullptr;
+    const TypedColumn *col = nullptr; // typed keys; null = interned getGroupKey text
+    double perBucket = 100.0;
+    std::unordered_map<std::string, int64_t> ids;
+};
+
+struct GroupByLevel
+{
+    int docCol = -1;
+    bool descending = false; // group order (from the column's sort key, if any)
+};
+
+struct GroupByNode
+{
+    int parent = -1; // index into the node list; -1 = top level
+    int level = 0;
+    int64_t key = 0;        // level key (see ColumnDef::typedGroupKey)
+    int keyRow = -1;        // a source row holding the group's key (label)
+    int begin = 0, end = 0; // the group's rows in the scattered row list
+    std::vector<AggState> aggs;        // AggPlan::Slots() states
+    std::vector<SketchState> sketches; // AggPlan::SketchSlots() sketches
+    std::vector<CustomState> customs;  // AggPlan::CustomSlots() states
+};
+
+// A group in the making: (parent group, key), probed per row and level.
+struct GroupSlot
+{
+    int parent;
+    int64_t key;
+    bool operator==(const GroupSlot &) const = default;
+};
+
+struct GroupSlotHash
+{
+    size_t operator()(const GroupSlot &s) const
+    {
+        uint64_t h = static_cast<uint64_t>(s.key) * 0x9E3779B97F4A7C15ull;
+        h ^= static_cast<uint64_t>(s.parent + 1) + (h >> 29);
+        return static_cast<size_t>(h * 0xBF58476D1CE4E5B9ull);
+    }
+};
+
+// ---- Hash group-by ----
+// Assigns rows to groups in one pass: each level yields an integer key per row
+// and (parent group, key) is probed in one hash table, so a row costs one probe
+// per level and rows are never compared with each other. Typed-key columns read
+// the key straight from the column store (no strings per row); others intern
+// their getGroupKey text. Aggregates run over each leaf group's rows once they
+// are contiguous; parent states are then merged bottom-up from their children,
+// so aggregation costs O(rows + groups) at any depth.
+//
+// Leaf aggregation runs on `pool` in tasks of about AggTaskRows rows: runs of
+// small leaves share a task, large leaves are cut into slices whose states are
+// merged in slice order. The cut depends only on the group sizes, so results
+// (double sums included) are the same for any number of threads.
+//
+// Only the groups are then ordered (children by key, per level direction), and
+// `rows` is rewritten with a stable scatter so every group is a contiguous
+// range, keeping the incoming row order inside each group. `nodes` comes out in
+// preorder.
+void HashGroupBy(const GridDocument &doc, ColumnStore &store,
+                 const std::vector<GroupByLevel> &levels,
+                 const AggPlan &aggs, ThreadPool &pool, std::vector<int> &rows,
+                 std::vector<GroupByNode> &nodes);
+
+// The steps after row assignment, shared with RollupCache. ArrangeGroups
+// orders `created` (children by key, per level direction), moves it into
+// `nodes` in preorder with row ranges, and scatters `rows` stably by leaf. On
+// entry a leaf's `end` holds its row count and leafOf[i] is the created leaf
+// of rows[i]. RollUpGroups merges every node's states into its parent's.
+void ArrangeGroups(const GridDocument &doc, const std::vector<GroupKeys> &keys,
+                   const std::vector<GroupByLevel> &levels, std::vector<GroupByNode> &created,
+                   const std::vector<int> &leafOf, std::vector<int> &rows, std::vector<GroupByNode> &nodes);
+void RollUpGroups(const AggPlan &aggs, std::vector<GroupByNode> &nodes);
+
+} // namespace gird
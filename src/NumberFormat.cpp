@@ -0,0 +1,93 @@
+#include "NumberFormat.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace gird
+{
+
+namespace
+{
+
+// Digits of the integer part in [begin, end) get a ',' every three; returns the new end.
+char *GroupThousands(char *begin, char *end, char *limit)
+{
+    char *digits = begin + (*begin == '-' ? 1 : 0);
+    char *intEnd = digits;
+    while (intEnd < end && *intEnd >= '0' && *intEnd <= '9')
+        ++intEnd;
+    const int count = static_cast<int>(intEnd - digits);
+    const int commas = (count - 1) / 3;
+    if (commas <= 0 || end + commas > limit)
+        return end;
+
+    // Shift from the back: tail first, then the integer digits with commas
+    std::memmove(intEnd + commas, intEnd, static_cast<size_t>(end - intEnd));
+    char *to = intEnd + commas;
+    char *from = intEnd;
+    for (int i = 0; from > digits; ++i)
+    {
+        if (i > 0 && i % 3 == 0)
+            *--to = ',';
+        *--to = *--from;
+    }
+    return end + commas;
+}
+
+// Appends the unit, grouping the integer digits first when asked (never for a
+// mantissa, where "1,234e+05" would misread).
+size_t Finish(char *out, char *end, const NumberFormat &fmt, bool group)
+{
+    char *const limit = out + MaxNumberChars;
+    if (group && fmt.thousands)
+        end = GroupThousands(out, end, limit);
+    const char *unit = fmt.unit == NumberFormat::Unit::Percent ? "%"
+                       : fmt.unit == NumberFormat::Unit::Bps   ? " bp"
+                                                               : "";
+    const size_t n = std::strlen(unit);
+    if (end + n <= limit)
+    {
+        std::memcpy(end, unit, n);
+        end += n;
+    }
+    return static_cast<size_t>(end - out);
+}
+
+} // namespace
+
+size_t FormatNumber(double x, const NumberFormat &fmt, char *out)
+{
+    char *const limit = out + MaxNumberChars - 8; // room for separators and unit
+    const bool scientific =
+        fmt.notation == NumberFormat::Notation::Scientific ||
+        (fmt.notation == NumberFormat::Notation::Auto && x != 0.0 && std::fabs(x) < NumberFormat::SmallMagnitude);
+
+    std::to_chars_result r{};
+    if (!scientific)
+        r = std::to_chars(out, limit, x, std::chars_format::fixed, fmt.precision);
+    if (!scientific && r.ec == std::errc{})
+        return Finish(out, r.ptr, fmt, true);
+    r = std::to_chars(out, limit, x, std::chars_format::scientific, fmt.precision);
+    return r.ec == std::errc{} ? Finish(out, r.ptr, fmt, false) : 0;
+}
+
+size_t FormatInteger(int64_t x, const NumberFormat &fmt, char *out)
+{
+    const auto r = std::to_chars(out, out + MaxNumberChars - 8, x);
+    return Finish(out, r.ptr, fmt, true);
+}
+
+std::string NumberText(double x, const NumberFormat &fmt)
+{
+    char buf[MaxNumberChars];
+    return std::string(buf, FormatNumber(x, fmt, buf));
+}
+
+std::string IntegerText(int64_t x, const NumberFormat &fmt)
+{
+    char buf[MaxNumberChars];
+    return std::string(buf, FormatInteger(x, fmt, buf));
+}
+
+} // namespace gird
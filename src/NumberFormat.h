@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace gird
+{
+
+// ---- Number display format ----
+// How a numeric column (and the aggregates over it) prints. Units only append
+// their sign: values are stored in percent / basis points already.
+struct NumberFormat
+{
+    enum class Notation
+    {
+        Fixed,
+        Scientific,
+        Auto // scientific for magnitudes below SmallMagnitude (small Greeks), else fixed
+    };
+    enum class Unit
+    {
+        None,
+        Percent, // "12.50%"
+        Bps      // "35.0 bp"
+    };
+
+    static constexpr double SmallMagnitude = 1e-3;
+
+    int precision = 2;      // digits after the point (mantissa digits when scientific)
+    bool thousands = false; // "1,234,567.89"
+    Notation notation = Notation::Fixed;
+    Unit unit = Unit::None;
+};
+
+// Counts (Count, Distinct, top-k tallies, "Count:" headers)
+inline constexpr NumberFormat CountFormat{0, true};
+
+// Room FormatNumber / FormatInteger may use
+inline constexpr size_t MaxNumberChars = 64;
+
+// Write into out[0, MaxNumberChars) and return the length: std::to_chars, no
+// allocation. Integers ignore `precision`; fixed values too long for the buffer
+// fall back to scientific.
+size_t FormatNumber(double x, const NumberFormat &fmt, char *out);
+size_t FormatInteger(int64_t x, const NumberFormat &fmt, char *out);
+
+// Allocating conveniences for text that is stored (summaries, group labels)
+[[nodiscard]] std::string NumberText(double x, const NumberFormat &fmt = {});
+[[nodiscard]] std::string IntegerText(int64_t x, const NumberFormat &fmt = CountFormat);
+
+} // namespace gird
@@ -0,0 +1,73 @@
+#include "PipelineStats.h"
+
+#include <algorithm>
+
+namespace gird
+{
+
+const char *StageName(PipelineStage stage)
+{
+    switch (stage)
+    {
+    case PipelineStage::Indices:
+        return "Filter + sort";
+    case PipelineStage::Groups:
+        return "Group";
+    case PipelineStage::Summaries:
+        return "Summaries";
+    case PipelineStage::ViewColumns:
+        return "View columns";
+    case PipelineStage::Draw:
+        return "Draw";
+    case PipelineStage::Persistence:
+        return "Persistence";
+    default:
+        return "?";
+    }
+}
+
+void StageTimes::Add(double value)
+{
+    ms[next] = static_cast<float>(value);
+    next = (next + 1) % Window;
+    filled = std::min(filled + 1, Window);
+    ++runs;
+}
+
+StageTimes::Summary StageTimes::Summarize() const
+{
+    Summary s;
+    s.samples = filled;
+    s.runs = runs;
+    if (filled == 0)
+        return s;
+
+    s.lastMs = ms[(next + Window - 1) % Window];
+    std::array<float, Window> sorted;
+    std::copy(ms.begin(), ms.begin() + filled, sorted.begin()); // ring order does not matter
+    auto at = [&](double q)
+    {
+        const int k = std::min(filled - 1, static_cast<int>(q * filled));
+        std::nth_element(sorted.begin(), sorted.begin() + k, sorted.begin() + filled);
+        return static_cast<double>(sorted[k]);
+    };
+    s.p50Ms = at(0.50);
+    s.p95Ms = at(0.95);
+    s.maxMs = *std::max_element(sorted.begin(), sorted.begin() + filled);
+    return s;
+}
+
+void StageTimes::Clear()
+{
+    next = 0;
+    filled = 0;
+    runs = 0;
+}
+
+void PipelineStats::Clear()
+{
+    for (StageTimes &t : stages)
+        t.Clear();
+}
+
+} // namespace gird
@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace gird
+{
+
+enum class PipelineStage
+{
+    Indices,     // RebuildIndices: filter + sort
+    Groups,      // RebuildGroups: group-by, rollups, render list
+    Summaries,   // EnsureSummaries calls that format or compute something
+    ViewColumns, // RebuildViewColumns
+    Draw,        // table rows on screen (summaries formatted on the way included)
+    Persistence, // preset save / load / list / delete
+    Count
+};
+
+[[nodiscard]] const char *StageName(PipelineStage stage);
+
+// ---- Rolling timings of one stage ----
+// The last Window samples in a ring; percentiles are taken when queried, so
+// recording costs a clock read and a store.
+class StageTimes
+{
+  public:
+    static constexpr int Window = 256;
+
+    struct Summary
+    {
+        int samples = 0;   // in the window
+        uint64_t runs = 0; // since Clear
+        double lastMs = 0.0, p50Ms = 0.0, p95Ms = 0.0, maxMs = 0.0; // max: over the window
+    };
+
+    void Add(double ms);
+    [[nodiscard]] Summary Summarize() const;
+    void Clear();
+
+  private:
+    std::array<float, Window> ms{};
+    int next = 0;
+    int filled = 0;
+    uint64_t runs = 0;
+};
+
+// ---- Per-view pipeline instrumentation ----
+// Stage timings plus the sizes they ran over, queried with GridController::Stats.
+struct PipelineStats
+{
+    std::array<StageTimes, static_cast<size_t>(PipelineStage::Count)> stages;
+
+    // Filled by GridController::Stats
+    int sourceRows = 0; // rows in doc->source
+    int rows = 0;       // after the filter (vm->indices)
+    int groups = 0;     // group nodes
+    int renderRows = 0;
+
+    [[nodiscard]] StageTimes &operator[](PipelineStage s) { return stages[static_cast<size_t>(s)]; }
+    [[nodiscard]] const StageTimes &operator[](PipelineStage s) const { return stages[static_cast<size_t>(s)]; }
+    void Clear();
+};
+
+// Adds the time from construction to destruction to one stage, unless dismissed
+class StageTimer
+{
+  public:
+    StageTimer(PipelineStats &stats, PipelineStage stage)
+        : times(&stats[stage]), start(std::chrono::steady_clock::now())
+    {
+    }
+    ~StageTimer()
+    {
+        if (times)
+            times->Add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    StageTimer(const StageTimer &) = delete;
+    StageTimer &operator=(const StageTimer &) = delete;
+
+    // Nothing worth recording happened (e.g. every summary was ready)
+    void Dismiss() { times = nullptr; }
+
+  private:
+    StageTimes *times;
+    std::chrono::steady_clock::time_point start;
+};
+
+} // namespace gird
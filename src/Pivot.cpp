@@ -0,0 +1,236 @@
+#include "Pivot.h"
+#include "ColumnStore.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+namespace gird
+{
+
+namespace
+{
+
+// Rows per leaf task (runs of leaves share one)
+constexpr int PivotTaskRows = 1 << 15;
+
+} // namespace
+
+PivotKeys BuildPivotKeys(const GridDocument &doc, ColumnStore &store, int docCol, int maxKeys)
+{
+    PivotKeys out;
+    out.docCol = docCol;
+    out.generation = store.Generation();
+    const int rowCount = store.RowCount();
+
+    // Distinct keys with a row holding each, in first-seen order
+    GroupKeys reader(doc, store, docCol);
+    std::unordered_map<int64_t, int> seen;
+    std::vector<int64_t> keys;
+    std::vector<int> keyRow;
+    out.ofRow.resize(rowCount);
+    for (int r = 0; r < rowCount; ++r)
+    {
+        const int64_t key = reader.KeyOf(doc, r);
+        auto [it, inserted] = seen.try_emplace(key, static_cast<int>(keys.size()));
+        if (inserted)
+        {
+            keys.push_back(key);
+            keyRow.push_back(r);
+        }
+        out.ofRow[r] = it->second;
+    }
+
+    // Column value order; first-seen ids are renumbered to it
+    std::vector<int> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (reader.Ordered())
+        std::sort(order.begin(), order.end(), [&](int a, int b)
+                  { return reader.Compare(doc, keys[a], keyRow[a], keys[b], keyRow[b]) < 0; });
+    const int kept = std::min(static_cast<int>(order.size()), std::max(maxKeys, 0));
+    std::vector<int> rank(keys.size(), -1);
+    for (int i = 0; i < kept; ++i)
+    {
+        rank[order[i]] = i;
+        out.labels.push_back(GridController::GetGroupKey(doc, docCol, doc.source->RowAt(keyRow[order[i]])));
+    }
+    out.dropped = static_cast<int>(keys.size()) - kept;
+    for (int &k : out.ofRow)
+        k = rank[k];
+    return out;
+}
+
+void PivotCube::Build(const AggPlan &plan, ThreadPool &pool, const PivotKeys &keys,
+                      const std::vector<int> &rows, const std::vector<GroupByNode> &nodes, int leafLevel,
+                      int firstNode)
+{
+    cells.assign(firstNode + nodes.size(), NodeCells{});
+    const size_t slots = plan.Slots();
+    const size_t sketchSlots = plan.SketchSlots();
+    const size_t customSlots = plan.CustomSlots();
+
+    // ---- Leaves: runs of leaves per task ----
+    std::vector<std::pair<int, int>> tasks; // leaf nodes [first, last)
+    int taskRows = 0;
+    for (int n = 0; n < static_cast<int>(nodes.size()); ++n)
+    {
+        if (nodes[n].level != leafLevel)
+            continue;
+        const int count = nodes[n].end - nodes[n].begin;
+        if (tasks.empty() || taskRows + count > PivotTaskRows)
+        {
+            tasks.emplace_back(n, n + 1);
+            taskRows = 0;
+        }
+        tasks.back().second = n + 1;
+        taskRows += count;
+    }
+
+    pool.ParallelFor(
+        static_cast<int>(tasks.size()),
+        [&](int t)
+        {
+            // Per-task scratch sized by the pivot values, reused across its leaves
+            std::vector<int> count(keys.Count(), 0), start(keys.Count(), 0);
+            std::vector<int> present, bucket;
+            for (int n = tasks[t].first; n < tasks[t].second; ++n)
+            {
+                const GroupByNode &g = nodes[n];
+                if (g.level != leafLevel)
+                    continue;
+
+                present.clear();
+                int total = 0;
+                for (int i = g.begin; i < g.end; ++i)
+                    if (const int k = keys.ofRow[rows[i]]; k >= 0)
+                    {
+                        if (count[k]++ == 0)
+                            present.push_back(k);
+                        ++total;
+                    }
+                std::sort(present.begin(), present.end());
+
+                // Stable bucket of the leaf's rows by pivot index
+                int at = 0;
+                for (int k : present)
+                {
+                    start[k] = at;
+                    at += count[k];
+                }
+                bucket.resize(total);
+                for (int i = g.begin; i < g.end; ++i)
+                    if (const int k = keys.ofRow[rows[i]]; k >= 0)
+                        bucket[start[k]++] = rows[i];
+
+                NodeCells &c = cells[firstNode + n];
+                const size_t m = present.size();
+                c.keys = present;
+                c.rows.resize(m);
+                c.states.assign(m * slots, AggState{});
+                c.sketches.assign(m * sketchSlots, SketchState{});
+                c.customs.assign(m * customSlots, CustomState{});
+                at = 0;
+                for (size_t j = 0; j < m; ++j)
+                {
+                    const int k = present[j];
+                    c.rows[j] = count[k];
+                    plan.Accumulate(bucket.data() + at, count[k], c.states.data() + j * slots,
+                                    c.sketches.data() + j * sketchSlots, c.customs.data() + j * customSlots);
+                    at += count[k];
+                    count[k] = 0;
+                }
+            }
+        });
+
+    // ---- Parents from children (preorder: children follow their parent) ----
+    for (int n = static_cast<int>(nodes.size()) - 1; n >= 0; --n)
+        if (const int p = nodes[n].parent; p >= 0)
+            MergeInto(plan, cells[firstNode + p], cells[firstNode + n]);
+    if (firstNode > 0)
+        for (int n = 0; n < static_cast<int>(nodes.size()); ++n)
+            if (nodes[n].parent < 0)
+                MergeInto(plan, cells[0], cells[firstNode + n]);
+}
+
+void PivotCube::MergeInto(const AggPlan &plan, NodeCells &into, const NodeCells &from)
+{
+    const size_t slots = plan.Slots();
+    const size_t sketchSlots = plan.SketchSlots();
+    const size_t customSlots = plan.CustomSlots();
+
+    // Both key lists are ascending: merge them, folding shared keys
+    NodeCells out;
+    const size_t cap = into.keys.size() + from.keys.size();
+    out.keys.reserve(cap);
+    out.rows.reserve(cap);
+    out.states.reserve(cap * slots);
+    out.sketches.reserve(cap * sketchSlots);
+    out.customs.reserve(cap * customSlots);
+    auto take = [&](const NodeCells &src, size_t j)
+    {
+        out.keys.push_back(src.keys[j]);
+        out.rows.push_back(src.rows[j]);
+        out.states.insert(out.states.end(), src.states.begin() + j * slots, src.states.begin() + (j + 1) * slots);
+        out.sketches.insert(out.sketches.end(), src.sketches.begin() + j * sketchSlots,
+                            src.sketches.begin() + (j + 1) * sketchSlots);
+        out.customs.insert(out.customs.end(), src.customs.begin() + j * customSlots,
+                           src.customs.begin() + (j + 1) * customSlots);
+    };
+
+    size_t a = 0, b = 0;
+    while (a < into.keys.size() || b < from.keys.size())
+    {
+        if (b == from.keys.size() || (a < into.keys.size() && into.keys[a] < from.keys[b]))
+            take(into, a++);
+        else if (a == into.keys.size() || from.keys[b] < into.keys[a])
+            take(from, b++);
+        else
+        {
+            take(into, a++);
+            const size_t j = out.keys.size() - 1;
+            out.rows[j] += from.rows[b];
+            plan.Merge(from.states.data() + b * slots, from.sketches.data() + b * sketchSlots,
+                       from.customs.data() + b * customSlots, out.states.data() + j * slots,
+                       out.sketches.data() + j * sketchSlots, out.customs.data() + j * customSlots);
+            ++b;
+        }
+    }
+    into = std::move(out);
+}
+
+void PivotCube::Format(int node, const AggPlan &plan, int firstCol, const std::vector<int> &totals,
+                       std::vector<std::string> &summaryByCol) const
+{
+    if (node < 0 || node >= static_cast<int>(cells.size()) || totals.empty())
+        return;
+    const NodeCells &c = cells[node];
+    const size_t slots = plan.Slots();
+    const size_t sketchSlots = plan.SketchSlots();
+    const size_t customSlots = plan.CustomSlots();
+
+    // Each cell formats as the totals would, then moves into its pivot columns
+    std::vector<std::string> text(*std::max_element(totals.begin(), totals.end()) + 1);
+    const int width = static_cast<int>(totals.size());
+    for (size_t j = 0; j < c.keys.size(); ++j)
+    {
+        plan.Format(c.states.data() + j * slots, c.sketches.data() + j * sketchSlots,
+                    c.customs.data() + j * customSlots, c.rows[j], text);
+        for (int a = 0; a < width; ++a)
+        {
+            const size_t col = firstCol + static_cast<size_t>(c.keys[j]) * width + a;
+            if (col < summaryByCol.size())
+                summaryByCol[col] = std::move(text[totals[a]]);
+        }
+    }
+}
+
+size_t PivotCube::CellCount() const
+{
+    size_t n = 0;
+    for (const NodeCells &c : cells)
+        n += c.keys.size();
+    return n;
+}
+
+} // namespace gird
@@ -0,0 +1,72 @@
+#pragma once
+#include "Aggregate.h"
+#include "GroupBy.h"
+
+#include <string>
+#include <vector>
+
+namespace gird
+{
+
+class ThreadPool;
+
+// ---- Pivot keys: the values a pivot column spreads into columns ----
+// Read over every source row, not just the filtered ones, so the generated
+// columns stay put while filters change. Keys are in column value order;
+// past `maxKeys` values the rest are dropped (counted, not shown).
+struct PivotKeys
+{
+    int docCol = -1;                 // -1 = pivot off
+    uint64_t generation = 0;         // ColumnStore::Generation() the keys were read at
+    std::vector<std::string> labels; // per pivot index (the getGroupKey text)
+    std::vector<int> ofRow;          // pivot index per source row; -1 = dropped
+    int dropped = 0;
+
+    [[nodiscard]] int Count() const { return static_cast<int>(labels.size()); }
+};
+
+[[nodiscard]] PivotKeys BuildPivotKeys(const GridDocument &doc, ColumnStore &store, int docCol,
+                                       int maxKeys);
+
+// ---- Sparse pivot cube ----
+// Aggregate cells keyed by (group node, pivot index), stored only for pairs
+// that occur: each node keeps its present pivot indices in order, with one
+// set of AggPlan states per cell. Leaves are filled from their rows (bucketed
+// by pivot index, then accumulated through the plan, on the worker pool), and
+// parents are merged from their children like the group states, so memory
+// follows the occupied cells, never groups x pivot values.
+class PivotCube
+{
+  public:
+    void Clear() { cells.clear(); }
+
+    // Cells for HashGroupBy's `nodes` (preorder, leaves on `leafLevel` over
+    // `rows`); node n is stored at firstNode + n. With firstNode > 0, slot 0
+    // gets the grand total (merged from the roots).
+    void Build(const AggPlan &plan, ThreadPool &pool, const PivotKeys &keys, const std::vector<int> &rows,
+               const std::vector<GroupByNode> &nodes, int leafLevel, int firstNode);
+
+    // Formats node's cells into summaryByCol: pivot index k and aggregate a
+    // land in column firstCol + k * totals.size() + a, formatted like the
+    // plan's output in view column totals[a].
+    void Format(int node, const AggPlan &plan, int firstCol, const std::vector<int> &totals,
+                std::vector<std::string> &summaryByCol) const;
+
+    [[nodiscard]] size_t CellCount() const;
+
+  private:
+    struct NodeCells
+    {
+        std::vector<int> keys; // present pivot indices, ascending
+        std::vector<int64_t> rows;
+        std::vector<AggState> states; // keys.size() * plan.Slots()
+        std::vector<SketchState> sketches;
+        std::vector<CustomState> customs;
+    };
+
+    static void MergeInto(const AggPlan &plan, NodeCells &into, const NodeCells &from);
+
+    std::vector<NodeCells> cells; // per view-model group node
+};
+
+} // namespace gird
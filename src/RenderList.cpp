@@ -0,0 +1,214 @@
+#include "GridFramework.h"
+
+#include <algorithm>
+
+namespace gird
+{
+
+void RenderList::Clear()
+{
+    entries.assign(1, Entry{}); // just the root
+    children.clear();
+    fenwick.clear();
+    leaves.clear();
+    rows = nullptr;
+}
+
+void RenderList::Build(const std::vector<GroupNode> &nodes, const std::vector<char> &expanded,
+                       const std::vector<int> &rowList, int topRows)
+{
+    const int n = static_cast<int>(nodes.size());
+    entries.assign(n + 1, Entry{});
+    leaves.clear();
+    rows = &rowList;
+
+    const int root = n;
+    entries[root].detail = topRows;
+
+    // Child blocks: count per parent, then fill in node order (siblings stay in preorder)
+    for (int v = 0; v < n; ++v)
+    {
+        Entry &e = entries[v];
+        const GroupNode &g = nodes[v];
+        e.parent = g.parent < 0 ? root : g.parent;
+        e.indent = g.indent;
+        e.begin = g.begin;
+        e.detail = g.detailRows;
+        e.detailIndent = g.indent + 1;
+        e.expanded = expanded[v] != 0;
+        ++entries[e.parent].childCount;
+        if (e.detail > 0)
+            leaves.push_back(v);
+    }
+    int start = 0;
+    for (Entry &e : entries)
+    {
+        e.childStart = start;
+        start += e.childCount;
+        e.childCount = 0;
+    }
+    children.assign(start, 0);
+    fenwick.assign(start, 0);
+    for (int v = 0; v < n; ++v)
+    {
+        Entry &p = entries[entries[v].parent];
+        entries[v].slot = p.childCount++;
+        children[p.childStart + entries[v].slot] = v;
+    }
+
+    // Sizes bottom-up: children always come after their parent
+    for (int v = n - 1; v >= 0; --v)
+    {
+        const Entry &e = entries[v];
+        Entry &p = entries[e.parent];
+        const int size = Visible(v);
+        fenwick[p.childStart + e.slot] = size;
+        p.childRows += size;
+    }
+
+    // Turn each block of sizes into a Fenwick tree in place (linear build)
+    for (const Entry &e : entries)
+        for (int i = 1; i <= e.childCount; ++i)
+            if (const int j = i + (i & -i); j <= e.childCount)
+                fenwick[e.childStart + j - 1] += fenwick[e.childStart + i - 1];
+}
+
+int RenderList::Size() const
+{
+    if (entries.empty())
+        return 0;
+    const Entry &r = entries[Root()];
+    return r.childRows + r.detail;
+}
+
+int RenderList::Visible(int e) const
+{
+    const Entry &en = entries[e];
+    return 1 + (en.expanded ? en.childRows + en.detail : 0);
+}
+
+bool RenderList::Collapsible(int node) const
+{
+    const Entry &e = entries[node];
+    return e.childCount > 0 || e.detail > 0;
+}
+
+int RenderList::Prefix(const Entry &e, int slots) const
+{
+    int sum = 0;
+    for (int i = slots; i > 0; i -= i & -i)
+        sum += fenwick[e.childStart + i - 1];
+    return sum;
+}
+
+void RenderList::Add(const Entry &e, int slot, int delta)
+{
+    for (int i = slot + 1; i <= e.childCount; i += i & -i)
+        fenwick[e.childStart + i - 1] += delta;
+}
+
+RenderRow RenderList::At(int index) const
+{
+    int e = Root();
+    for (;;)
+    {
+        const Entry &en = entries[e];
+        if (index >= en.childRows)
+        {
+            const int k = index - en.childRows;
+            return {RenderRowKind::DataRow, e == Root() ? 0 : en.detailIndent, (*rows)[en.begin + k], -1,
+                    en.begin + k};
+        }
+
+        // Fenwick descent: the last slot whose prefix sum is <= index
+        int slot = 0;
+        int step = 1;
+        while (step * 2 <= en.childCount)
+            step *= 2;
+        for (; step > 0; step /= 2)
+            if (slot + step <= en.childCount && fenwick[en.childStart + slot + step - 1] <= index)
+            {
+                slot += step;
+                index -= fenwick[en.childStart + slot - 1];
+            }
+
+        const int child = children[en.childStart + slot];
+        if (index == 0)
+            return {RenderRowKind::GroupHeader, entries[child].indent, -1, child};
+        index -= 1; // the child's header
+        e = child;
+    }
+}
+
+void RenderList::SetExpanded(int node, bool expanded)
+{
+    if (entries[node].expanded == expanded)
+        return;
+
+    const int before = Visible(node);
+    entries[node].expanded = expanded;
+    const int delta = Visible(node) - before;
+
+    // Ancestors grow or shrink until one is collapsed (its size does not change)
+    for (int c = node;;)
+    {
+        Entry &p = entries[entries[c].parent];
+        Add(p, entries[c].slot, delta);
+        p.childRows += delta;
+        c = entries[c].parent;
+        if (c == Root() || !p.expanded)
+            break;
+    }
+}
+
+int RenderList::IndexOf(int node) const
+{
+    int index = 0;
+    for (int c = node; c != Root(); c = entries[c].parent)
+    {
+        const Entry &p = entries[entries[c].parent];
+        index += Prefix(p, entries[c].slot);
+        if (entries[c].parent != Root())
+        {
+            if (!p.expanded)
+                return -1;
+            index += 1; // the parent's header
+        }
+    }
+    return index;
+}
+
+int RenderList::DetailIndexOf(int node, int k) const
+{
+    if (node < 0)
+        return entries[Root()].childRows + k;
+
+    const Entry &e = entries[node];
+    const int header = IndexOf(node);
+    if (header < 0 || !e.expanded)
+        return -1;
+    return header + 1 + e.childRows + k;
+}
+
+bool RenderList::Locate(int pos, int &node) const
+{
+    if (entries.empty())
+        return false;
+    if (pos < entries[Root()].detail)
+    {
+        node = -1;
+        return true;
+    }
+
+    auto it = std::upper_bound(leaves.begin(), leaves.end(), pos,
+                               [&](int p, int v) { return p < entries[v].begin; });
+    if (it == leaves.begin())
+        return false;
+    const Entry &e = entries[*--it];
+    if (pos >= e.begin + e.detail)
+        return false;
+    node = *it;
+    return true;
+}
+
+} // namespace gird
@@ -0,0 +1,213 @@
+#include "RollupCache.h"
+#include "ColumnStore.h"
+
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+
+namespace gird
+{
+
+namespace
+{
+
+// Columns an entry's keys and states were read from
+std::vector<int> ReadColumns(const std::vector<int> &groupCols, const AggPlan &aggs)
+{
+    std::vector<int> cols = aggs.Columns();
+    cols.insert(cols.end(), groupCols.begin(), groupCols.end());
+    return cols;
+}
+
+} // namespace
+
+void RollupCache::GroupBy(const GridDocument &doc, ColumnStore &store, const std::vector<GroupByLevel> &levels,
+                          const AggPlan &aggs, ThreadPool &pool, std::vector<int> &rows,
+                          std::vector<GroupByNode> &nodes)
+{
+    nodes.clear();
+    if (levels.empty())
+        return;
+
+    // Entries whose grouping or aggregate columns changed never match again;
+    // updates to other columns leave them be
+    for (size_t i = 0; i < entries.size();)
+        if (entries[i].generation != store.Generation(ReadColumns(entries[i].cols, entries[i].aggs)))
+        {
+            bytes -= entries[i].bytes;
+            entries.erase(entries.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+        else
+            ++i;
+
+    // Row set identity, independent of the row order
+    uint64_t sum = 0, mix = 0;
+    for (int r : rows)
+    {
+        const uint64_t h = HashKey(static_cast<uint64_t>(r));
+        sum += h;
+        mix ^= h;
+    }
+    const uint64_t rowHash = sum ^ std::rotl(mix, 32);
+
+    // The smallest entry covering every grouping column
+    Entry *best = nullptr;
+    for (Entry &e : entries)
+    {
+        if (e.rowCount != rows.size() || e.rowHash != rowHash || !e.aggs.SameLayout(aggs))
+            continue;
+        const bool covers = std::all_of(levels.begin(), levels.end(),
+                                        [&](const GroupByLevel &l)
+                                        { return std::find(e.cols.begin(), e.cols.end(), l.docCol) != e.cols.end(); });
+        if (covers && (!best || e.Leaves() < best->Leaves()))
+            best = &e;
+    }
+    if (best && Derive(doc, store, *best, levels, aggs, rows, nodes))
+    {
+        best->lastUse = ++clock;
+        return;
+    }
+
+    HashGroupBy(doc, store, levels, aggs, pool, rows, nodes);
+
+    Entry e;
+    std::vector<int> cols;
+    for (const GroupByLevel &level : levels)
+        cols.push_back(level.docCol);
+    e.generation = store.Generation(ReadColumns(cols, aggs));
+    e.rowCount = rows.size();
+    e.rowHash = rowHash;
+    e.leafOfRow.assign(store.RowCount(), -1);
+    Store(std::move(e), levels, aggs, rows, nodes);
+}
+
+bool RollupCache::Derive(const GridDocument &doc, ColumnStore &store, const Entry &e,
+                         const std::vector<GroupByLevel> &levels, const AggPlan &aggs, std::vector<int> &rows,
+                         std::vector<GroupByNode> &nodes) const
+{
+    // Cached leaf of each row; the row set only matched on size and hash, so a
+    // row the entry never saw means a collision
+    std::vector<int> leafOf(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        const int r = rows[i];
+        if (r < 0 || static_cast<size_t>(r) >= e.leafOfRow.size() || e.leafOfRow[r] < 0)
+            return false;
+        leafOf[i] = e.leafOfRow[r];
+    }
+
+    const int depth = static_cast<int>(levels.size());
+    const size_t width = e.cols.size();
+    std::vector<GroupKeys> keys;
+    std::vector<size_t> colAt;
+    keys.reserve(depth);
+    for (const GroupByLevel &level : levels)
+    {
+        keys.emplace_back(doc, store, level.docCol);
+        colAt.push_back(std::find(e.cols.begin(), e.cols.end(), level.docCol) - e.cols.begin());
+    }
+
+    // Cached leaves -> groups, as HashGroupBy does with rows
+    const size_t slots = aggs.Slots();
+    const size_t sketchSlots = aggs.SketchSlots();
+    const size_t customSlots = aggs.CustomSlots();
+    std::vector<GroupByNode> created;
+    std::unordered_map<GroupSlot, int, GroupSlotHash> nodeOf;
+    std::vector<int> leafOfCached(e.Leaves());
+    for (int f = 0; f < e.Leaves(); ++f)
+    {
+        int node = -1;
+        for (int l = 0; l < depth; ++l)
+        {
+            const int64_t key = e.keys[f * width + colAt[l]];
+            auto [it, inserted] = nodeOf.try_emplace(GroupSlot{node, key}, static_cast<int>(created.size()));
+            if (inserted)
+            {
+                GroupByNode g;
+                g.parent = node;
+                g.level = l;
+                g.key = key;
+                g.keyRow = e.keyRows[f];
+                g.aggs.resize(slots);
+                g.sketches.resize(sketchSlots);
+                g.customs.resize(customSlots);
+                created.push_back(std::move(g));
+            }
+            node = it->second;
+        }
+
+        GroupByNode &leaf = created[node];
+        leaf.end += e.leafRows[f]; // leaf row count until ranges are assigned
+        aggs.Merge(e.states.data() + f * slots, e.sketches.data() + f * sketchSlots,
+                   e.customs.data() + f * customSlots, leaf.aggs.data(), leaf.sketches.data(),
+                   leaf.customs.data());
+        leafOfCached[f] = node;
+    }
+
+    for (int &leaf : leafOf)
+        leaf = leafOfCached[leaf];
+
+    ArrangeGroups(doc, keys, levels, created, leafOf, rows, nodes);
+    RollUpGroups(aggs, nodes);
+    return true;
+}
+
+void RollupCache::Store(Entry e, const std::vector<GroupByLevel> &levels, const AggPlan &aggs,
+                        const std::vector<int> &rows, const std::vector<GroupByNode> &nodes)
+{
+    const int lastLevel = static_cast<int>(levels.size()) - 1;
+    const size_t width = levels.size();
+    e.aggs = aggs;
+    for (const GroupByLevel &level : levels)
+        e.cols.push_back(level.docCol);
+
+    std::vector<int64_t> path(width);
+    for (const GroupByNode &g : nodes)
+    {
+        if (g.level != lastLevel)
+            continue;
+        const int leaf = e.Leaves();
+        for (int n = static_cast<int>(&g - nodes.data()); n >= 0; n = nodes[n].parent)
+            path[nodes[n].level] = nodes[n].key;
+        e.keys.insert(e.keys.end(), path.begin(), path.end());
+        e.keyRows.push_back(g.keyRow);
+        e.leafRows.push_back(g.end - g.begin);
+        e.states.insert(e.states.end(), g.aggs.begin(), g.aggs.end());
+        e.sketches.insert(e.sketches.end(), g.sketches.begin(), g.sketches.end());
+        e.customs.insert(e.customs.end(), g.customs.begin(), g.customs.end());
+        for (int i = g.begin; i < g.end; ++i)
+            e.leafOfRow[rows[i]] = leaf;
+    }
+
+    e.bytes = sizeof(Entry) + e.keys.size() * sizeof(int64_t) +
+              (e.keyRows.size() + e.leafRows.size() + e.leafOfRow.size()) * sizeof(int) +
+              e.states.size() * sizeof(AggState) + e.customs.size() * sizeof(CustomState);
+    for (const SketchState &s : e.sketches)
+        e.bytes += SketchBytes(s);
+    if (e.bytes > budget)
+        return;
+
+    e.lastUse = ++clock;
+    bytes += e.bytes;
+    entries.push_back(std::move(e));
+    Evict();
+}
+
+void RollupCache::Evict()
+{
+    while (bytes > budget && !entries.empty())
+    {
+        auto oldest = std::min_element(entries.begin(), entries.end(),
+                                       [](const Entry &a, const Entry &b) { return a.lastUse < b.lastUse; });
+        bytes -= oldest->bytes;
+        entries.erase(oldest);
+    }
+}
+
+void RollupCache::Clear()
+{
+    entries.clear();
+    bytes = 0;
+}
+
+} // namespace gird
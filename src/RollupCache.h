@@ -0,0 +1,84 @@
+#pragma once
+#include "Aggregate.h"
+#include "GroupBy.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gird
+{
+
+class ColumnStore;
+class ThreadPool;
+
+// ---- Materialized rollups ----
+// Grouped results kept across grouping changes: each entry is the leaf level
+// of one grouping (a key per grouping column, the leaf's states and row count)
+// plus the leaf of every source row, for one row set and aggregate layout.
+// A grouping whose columns are all among a cached entry's columns, in any
+// order, is answered from it: its leaves are formed from the cached leaves'
+// keys, their states merged from the cached states, and rows scattered by
+// their cached leaf, so neither group keys nor aggregates are read again.
+//
+// Entries match on the generation of the columns they read (grouping and
+// aggregate columns, so updates elsewhere keep them), the row set (not its
+// order, so a sort change still hits) and AggPlan::SameLayout; a row set that
+// only matches by hash falls back to grouping from the rows. Merged results may differ
+// from a fresh group-by: double sums in the last bits, sketch estimates within
+// their error bounds. Least recently used entries go first once the cache
+// passes its memory budget.
+class RollupCache
+{
+  public:
+    static constexpr size_t DefaultBudgetBytes = size_t(256) << 20;
+
+    explicit RollupCache(size_t budgetBytes = DefaultBudgetBytes) : budget(budgetBytes) {}
+
+    // HashGroupBy, answered from the cache when an entry covers `levels`;
+    // otherwise grouped from the rows and cached.
+    void GroupBy(const GridDocument &doc, ColumnStore &store, const std::vector<GroupByLevel> &levels,
+                 const AggPlan &aggs, ThreadPool &pool, std::vector<int> &rows,
+                 std::vector<GroupByNode> &nodes);
+
+    void Clear();
+    [[nodiscard]] size_t MemoryBytes() const { return bytes; }
+
+  private:
+    struct Entry
+    {
+        uint64_t generation = 0; // ColumnStore::Generation over the columns read
+        size_t rowCount = 0;     // row set: size and order-free hash
+        uint64_t rowHash = 0;
+        AggPlan aggs;
+        std::vector<int> cols; // grouping columns, one key per leaf each
+
+        std::vector<int64_t> keys;   // leaf * cols.size() + column
+        std::vector<int> keyRows;    // per leaf: a row holding its keys
+        std::vector<int> leafRows;   // per leaf: row count
+        std::vector<AggState> states; // per leaf: aggs.Slots() each
+        std::vector<SketchState> sketches;
+        std::vector<CustomState> customs;
+        std::vector<int> leafOfRow; // per source row; -1 = not in the row set
+
+        size_t bytes = 0;
+        uint64_t lastUse = 0;
+
+        [[nodiscard]] int Leaves() const { return static_cast<int>(keyRows.size()); }
+    };
+
+    // False, leaving `nodes` alone, if a row has no cached leaf
+    bool Derive(const GridDocument &doc, ColumnStore &store, const Entry &e,
+                const std::vector<GroupByLevel> &levels, const AggPlan &aggs, std::vector<int> &rows,
+                std::vector<GroupByNode> &nodes) const;
+    void Store(Entry e, const std::vector<GroupByLevel> &levels, const AggPlan &aggs,
+               const std::vector<int> &rows, const std::vector<GroupByNode> &nodes);
+    void Evict();
+
+    std::vector<Entry> entries;
+    size_t budget = DefaultBudgetBytes;
+    size_t bytes = 0;
+    uint64_t clock = 0;
+};
+
+} // namespace gird
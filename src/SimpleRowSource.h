@@ -9,6 +9,39 @@ namespace gird {
 
             int RowCount() const override { return static_cast<int>(rows.size()); }
             const SimpleRow& RowAt(int row_index) const override { return rows[row_index]; }
+
+            // In-place update (ticks): bumps Version() and logs the row so column
+            // caches can patch just that row.
+            void SetCell(int row_index, int col, Value v)
+            {
+                rows[row_index][col] = std::move(v);
+                ++version;
+                if (changeLog.size() >= kMaxChangeLog)
+                {
+                    logStart = changeLog.back().first;
+                    changeLog.clear();
+                }
+                changeLog.emplace_back(version, row_index);
+            }
+
+            uint64_t Version() const override { return version; }
+
+            bool ChangedRowsSince(uint64_t since, std::vector<int>& out) const override
+            {
+                if (since < logStart)
+                    return false;
+                for (const auto& [v, row] : changeLog)
+                    if (v > since)
+                        out.push_back(row);
+                return true;
+            }
+
+        private:
+            static constexpr size_t kMaxChangeLog = 1 << 16;
+
+            uint64_t version = 0;
+            uint64_t logStart = 0; // versions <= logStart may be missing from changeLog
+            std::vector<std::pair<uint64_t, int>> changeLog; // (version, row)
         };
 
 } // namespace gird
@@ -0,0 +1,307 @@
+#include "Sketch.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace gird
+{
+
+// ---- DistinctSketch ----
+
+void DistinctSketch::Add(uint64_t hash)
+{
+    if (!registers.empty())
+    {
+        AddRegister(hash);
+        return;
+    }
+    auto it = std::lower_bound(sparse.begin(), sparse.end(), hash);
+    if (it != sparse.end() && *it == hash)
+        return;
+    sparse.insert(it, hash);
+    if (static_cast<int>(sparse.size()) > SparseLimit)
+        ToRegisters();
+}
+
+void DistinctSketch::AddRegister(uint64_t hash)
+{
+    const size_t index = hash >> (64 - Precision);
+    // Rank of the remaining bits; the guard bit caps it at 64 - Precision + 1
+    const uint64_t rest = (hash << Precision) | (uint64_t{1} << (Precision - 1));
+    const auto rank = static_cast<uint8_t>(std::countl_zero(rest) + 1);
+    registers[index] = std::max(registers[index], rank);
+}
+
+void DistinctSketch::ToRegisters()
+{
+    registers.assign(size_t{1} << Precision, 0);
+    for (uint64_t h : sparse)
+        AddRegister(h);
+    sparse.clear();
+    sparse.shrink_to_fit();
+}
+
+void DistinctSketch::Merge(const DistinctSketch &other)
+{
+    if (other.Exact())
+    {
+        if (!Exact())
+        {
+            for (uint64_t h : other.sparse)
+                AddRegister(h);
+            return;
+        }
+        std::vector<uint64_t> both;
+        both.reserve(sparse.size() + other.sparse.size());
+        std::set_union(sparse.begin(), sparse.end(), other.sparse.begin(), other.sparse.end(),
+                       std::back_inserter(both));
+        sparse.swap(both);
+        if (static_cast<int>(sparse.size()) > SparseLimit)
+            ToRegisters();
+        return;
+    }
+    if (Exact())
+        ToRegisters();
+    for (size_t i = 0; i < registers.size(); ++i)
+        registers[i] = std::max(registers[i], other.registers[i]);
+}
+
+double DistinctSketch::Estimate() const
+{
+    if (Exact())
+        return static_cast<double>(sparse.size());
+
+    const double m = static_cast<double>(registers.size());
+    double sum = 0.0;
+    int zeros = 0;
+    for (uint8_t r : registers)
+    {
+        sum += std::ldexp(1.0, -r);
+        zeros += (r == 0);
+    }
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+    const double estimate = alpha * m * m / sum;
+    // Small range: linear counting over the empty registers
+    if (estimate <= 2.5 * m && zeros > 0)
+        return m * std::log(m / zeros);
+    return estimate;
+}
+
+// ---- QuantileSketch ----
+
+int QuantileSketch::Capacity(int level) const
+{
+    const int depth = static_cast<int>(levels.size()) - 1 - level;
+    return std::max(2, static_cast<int>(std::ceil(K * std::pow(2.0 / 3.0, depth))));
+}
+
+void QuantileSketch::Add(double x)
+{
+    if (std::isnan(x))
+        return;
+    if (levels.empty())
+        levels.emplace_back();
+    levels[0].push_back(x);
+    ++n;
+    if (static_cast<int>(levels[0].size()) >= Capacity(0))
+        Compress();
+}
+
+void QuantileSketch::Compress()
+{
+    // Each compaction halves a level, so this ends; adding a top level shrinks
+    // the capacities below it, hence the rescan
+    for (bool again = true; again;)
+    {
+        again = false;
+        for (size_t h = 0; h < levels.size(); ++h)
+        {
+            if (static_cast<int>(levels[h].size()) < Capacity(static_cast<int>(h)))
+                continue;
+            if (h + 1 == levels.size())
+                levels.emplace_back();
+
+            std::vector<double> &level = levels[h];
+            std::vector<double> &up = levels[h + 1];
+            const bool keepOne = level.size() % 2 != 0;
+            const double kept = level.back();
+            if (keepOne)
+                level.pop_back();
+            std::sort(level.begin(), level.end());
+            coin ^= coin << 13;
+            coin ^= coin >> 17;
+            coin ^= coin << 5;
+            for (size_t i = coin & 1; i < level.size(); i += 2)
+                up.push_back(level[i]);
+            level.clear();
+            if (keepOne)
+                level.push_back(kept);
+            again = true;
+        }
+    }
+}
+
+void QuantileSketch::Merge(const QuantileSketch &other)
+{
+    if (other.n == 0)
+        return;
+    if (levels.size() < other.levels.size())
+        levels.resize(other.levels.size());
+    for (size_t h = 0; h < other.levels.size(); ++h)
+        levels[h].insert(levels[h].end(), other.levels[h].begin(), other.levels[h].end());
+    n += other.n;
+    Compress();
+}
+
+double QuantileSketch::Quantile(double q) const
+{
+    if (n == 0)
+        return std::numeric_limits<double>::quiet_NaN();
+
+    std::vector<std::pair<double, int64_t>> weighted;
+    int64_t total = 0;
+    for (size_t h = 0; h < levels.size(); ++h)
+        for (double x : levels[h])
+        {
+            weighted.emplace_back(x, int64_t{1} << h);
+            total += int64_t{1} << h;
+        }
+    std::sort(weighted.begin(), weighted.end());
+
+    const double target = std::clamp(q, 0.0, 1.0) * static_cast<double>(total);
+    int64_t seen = 0;
+    for (const auto &[x, w] : weighted)
+    {
+        seen += w;
+        if (static_cast<double>(seen) >= target)
+            return x;
+    }
+    return weighted.back().first;
+}
+
+size_t QuantileSketch::MemoryBytes() const
+{
+    size_t bytes = levels.capacity() * sizeof(std::vector<double>);
+    for (const auto &level : levels)
+        bytes += level.capacity() * sizeof(double);
+    return bytes;
+}
+
+// ---- TopKSketch ----
+
+void TopKSketch::Add(int64_t key)
+{
+    ++n;
+    const auto it = std::find(keys.begin(), keys.end(), key);
+    if (it != keys.end())
+    {
+        ++items[it - keys.begin()].count;
+        return;
+    }
+    if (static_cast<int>(items.size()) < Counters)
+    {
+        keys.push_back(key);
+        items.push_back({key, 1, 0});
+        return;
+    }
+    const auto min = std::min_element(items.begin(), items.end(),
+                                      [](const Item &a, const Item &b) { return a.count < b.count; });
+    keys[min - items.begin()] = key;
+    *min = {key, min->count + 1, min->count};
+}
+
+void TopKSketch::Merge(const TopKSketch &other)
+{
+    if (other.n == 0)
+        return;
+
+    // A key missing from a full sketch may have had up to its smallest count
+    const auto floor = [](const TopKSketch &s) -> int64_t
+    {
+        if (static_cast<int>(s.items.size()) < Counters)
+            return 0;
+        int64_t m = std::numeric_limits<int64_t>::max();
+        for (const Item &i : s.items)
+            m = std::min(m, i.count);
+        return m;
+    };
+    const int64_t floorThis = floor(*this);
+    const int64_t floorOther = floor(other);
+
+    std::vector<Item> both;
+    both.reserve(items.size() + other.items.size());
+    for (const Item &a : items)
+    {
+        const auto it = std::find(other.keys.begin(), other.keys.end(), a.key);
+        if (it != other.keys.end())
+        {
+            const Item &b = other.items[it - other.keys.begin()];
+            both.push_back({a.key, a.count + b.count, a.error + b.error});
+        }
+        else
+            both.push_back({a.key, a.count + floorOther, a.error + floorOther});
+    }
+    for (const Item &b : other.items)
+        if (std::find(keys.begin(), keys.end(), b.key) == keys.end())
+            both.push_back({b.key, b.count + floorThis, b.error + floorThis});
+
+    std::sort(both.begin(), both.end(), [](const Item &a, const Item &b)
+              { return a.count != b.count ? a.count > b.count : a.key < b.key; });
+    if (static_cast<int>(both.size()) > Counters)
+        both.resize(Counters);
+
+    items.swap(both);
+    keys.clear();
+    for (const Item &i : items)
+        keys.push_back(i.key);
+    n += other.n;
+}
+
+std::vector<TopKSketch::Item> TopKSketch::Top(int k) const
+{
+    std::vector<Item> top = items;
+    k = std::min(k, static_cast<int>(top.size()));
+    std::partial_sort(top.begin(), top.begin() + k, top.end(), [](const Item &a, const Item &b)
+                      { return a.count != b.count ? a.count > b.count : a.key < b.key; });
+    top.resize(k);
+    return top;
+}
+
+// ---- SketchState ----
+
+void MergeSketch(SketchState &into, const SketchState &from)
+{
+    if (std::holds_alternative<std::monostate>(from))
+        return;
+    if (std::holds_alternative<std::monostate>(into))
+    {
+        into = from;
+        return;
+    }
+    std::visit(
+        [&](auto &s)
+        {
+            using S = std::decay_t<decltype(s)>;
+            if constexpr (!std::is_same_v<S, std::monostate>)
+                if (const S *f = std::get_if<S>(&from))
+                    s.Merge(*f);
+        },
+        into);
+}
+
+size_t SketchBytes(const SketchState &s)
+{
+    size_t heap = 0;
+    std::visit(
+        [&](const auto &v)
+        {
+            if constexpr (!std::is_same_v<std::decay_t<decltype(v)>, std::monostate>)
+                heap = v.MemoryBytes();
+        },
+        s);
+    return sizeof(SketchState) + heap;
+}
+
+} // namespace gird
@@ -0,0 +1,125 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+namespace gird
+{
+
+// Mergeable summaries for the approximate aggregates. Each sketch folds rows
+// one at a time (Add) and combines with a sketch of a disjoint row set
+// (Merge), so group states roll up and parallel partials join like AggState.
+// Results depend only on the order of Adds and Merges, never on timing.
+
+// ---- Distinct count: HyperLogLog ----
+// Values are added as 64-bit hashes. Small sets keep the hashes themselves and
+// count exactly; past SparseLimit they move to 2^Precision one-byte registers.
+class DistinctSketch
+{
+  public:
+    static constexpr int Precision = 12;
+    static constexpr int SparseLimit = 256;
+    // Standard error of the estimate once registers are in use (1.04 / sqrt(m))
+    static constexpr double RelativeError = 0.01625;
+
+    void Add(uint64_t hash);
+    void Merge(const DistinctSketch &other);
+
+    [[nodiscard]] double Estimate() const;
+    [[nodiscard]] bool Exact() const { return registers.empty(); }
+    [[nodiscard]] size_t MemoryBytes() const { return sparse.capacity() * sizeof(uint64_t) + registers.capacity(); }
+
+  private:
+    void ToRegisters();
+    void AddRegister(uint64_t hash);
+
+    std::vector<uint64_t> sparse;   // sorted distinct hashes while exact
+    std::vector<uint8_t> registers; // leading-zero ranks, 2^Precision entries
+};
+
+// ---- Quantiles: KLL ----
+// Compactor levels of capacity K shrinking by 2/3 per level below the top;
+// a full level is sorted and every other item moves up with twice the weight.
+// Which half survives comes from a fixed-seed xorshift coin, so the same
+// input order always yields the same sketch. Exact below K values; NaN
+// values are skipped.
+class QuantileSketch
+{
+  public:
+    static constexpr int K = 200;
+    // Normalized rank error at K = 200 (99% confidence, as for the reference
+    // KLL implementation)
+    static constexpr double RankError = 0.0165;
+
+    void Add(double x);
+    void Merge(const QuantileSketch &other);
+
+    // Value at rank q in [0, 1]; NaN when empty.
+    [[nodiscard]] double Quantile(double q) const;
+    [[nodiscard]] int64_t Count() const { return n; }
+    [[nodiscard]] bool Exact() const { return levels.size() <= 1; }
+    [[nodiscard]] size_t MemoryBytes() const;
+
+  private:
+    [[nodiscard]] int Capacity(int level) const;
+    void Compress();
+
+    std::vector<std::vector<double>> levels; // level h items weigh 2^h
+    int64_t n = 0;
+    uint32_t coin = 0x9E3779B9u; // xorshift state: which half a compaction keeps
+};
+
+// ---- Most frequent values: space-saving ----
+// Counters keys with counts; a new key evicts the smallest counter and
+// inherits its count as `error`. A kept count overstates the true one by at
+// most `error` (never more than rows / Counters).
+class TopKSketch
+{
+  public:
+    static constexpr int Counters = 32;
+
+    struct Item
+    {
+        int64_t key = 0;
+        int64_t count = 0;
+        int64_t error = 0;
+    };
+
+    void Add(int64_t key);
+    void Merge(const TopKSketch &other);
+
+    // The k largest counts, ties by key.
+    [[nodiscard]] std::vector<Item> Top(int k) const;
+    [[nodiscard]] int64_t Count() const { return n; }
+    [[nodiscard]] size_t MemoryBytes() const
+    {
+        return keys.capacity() * sizeof(int64_t) + items.capacity() * sizeof(Item);
+    }
+
+  private:
+    std::vector<int64_t> keys; // parallel to items, scanned on Add
+    std::vector<Item> items;
+    int64_t n = 0;
+};
+
+// Sketch slot of an AggPlan: empty until its first row or merge.
+using SketchState = std::variant<std::monostate, DistinctSketch, QuantileSketch, TopKSketch>;
+
+// Folds `from` into `into` (same alternative, or either empty).
+void MergeSketch(SketchState &into, const SketchState &from);
+
+// Heap and inline bytes of a sketch slot.
+[[nodiscard]] size_t SketchBytes(const SketchState &s);
+
+// 64-bit mix of a key (splitmix64 finalizer) for DistinctSketch.
+[[nodiscard]] inline uint64_t HashKey(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+} // namespace gird
@@ -0,0 +1,104 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace gird
+{
+
+ThreadPool::ThreadPool(int threads)
+{
+    workers.reserve(std::max(threads, 0));
+    for (int i = 0; i < threads; ++i)
+        workers.emplace_back([this] { WorkerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    for (auto &t : workers)
+        t.join();
+}
+
+int ThreadPool::DefaultThreads()
+{
+#ifdef GIRD_SINGLE_THREADED
+    return 0;
+#else
+    const int hw = static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(hw - 1, 1);
+#endif
+}
+
+void ThreadPool::ParallelFor(int count, const std::function<void(int)> &body)
+{
+    if (workers.empty() || count <= 1)
+    {
+        for (int i = 0; i < count; ++i)
+            body(i);
+        return;
+    }
+
+    // Helpers that start after every index is claimed return without touching
+    // `body`, so only the claim/finish counters have to outlive this call
+    struct Shared
+    {
+        std::atomic<int> next{0};
+        int done = 0;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto shared = std::make_shared<Shared>();
+    auto run = [shared, &body, count]
+    {
+        int ran = 0;
+        for (int i; (i = shared->next.fetch_add(1)) < count; ++ran)
+            body(i);
+        if (ran == 0)
+            return;
+        std::lock_guard lock(shared->mutex);
+        shared->done += ran;
+        if (shared->done == count)
+            shared->finished.notify_all();
+    };
+
+    const int helpers = std::min(count - 1, Size());
+    for (int h = 0; h < helpers; ++h)
+        Enqueue(run);
+    run();
+
+    std::unique_lock lock(shared->mutex);
+    shared->finished.wait(lock, [&] { return shared->done == count; });
+}
+
+void ThreadPool::Enqueue(std::function<void()> job)
+{
+    {
+        std::lock_guard lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::WorkerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping)
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+} // namespace gird
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace gird
+{
+
+// ---- Fixed-size worker pool for background and parallel work ----
+// Jobs run in submission order on `Size()` workers. A pool with no workers
+// (GIRD_SINGLE_THREADED builds, e.g. WebAssembly without pthreads) runs each
+// job inline inside Submit, so callers never need a separate code path.
+// Destruction drops jobs that have not started and joins the running ones.
+class ThreadPool
+{
+  public:
+    explicit ThreadPool(int threads = DefaultThreads());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // hardware_concurrency - 1 (the UI thread keeps a core); 0 when single-threaded
+    [[nodiscard]] static int DefaultThreads();
+    [[nodiscard]] int Size() const { return static_cast<int>(workers.size()); }
+
+    // `done`, if set, runs on the worker once the future is ready (e.g. to wake
+    // a UI thread blocked on events).
+    template <class F>
+    auto Submit(F &&f, std::function<void()> done = {}) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> result = task->get_future();
+        if (workers.empty())
+            (*task)();
+        else
+            Enqueue(
+                [task, done = std::move(done)]
+                {
+                    (*task)();
+                    if (done)
+                        done();
+                });
+        return result;
+    }
+
+    // Runs body(0) .. body(count - 1) on the workers and the calling thread and
+    // returns when all have finished. Indices are claimed in order, so a worker
+    // busy with a long job only means the other threads take its share; which
+    // thread runs an index is unspecified, so bodies must write disjoint data.
+    void ParallelFor(int count, const std::function<void(int)> &body);
+
+  private:
+    void Enqueue(std::function<void()> job);
+    void WorkerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
+
+} // namespace gird
@@ -0,0 +1,189 @@
+#include "TrigramIndex.h"
+#include "ColumnStore.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+namespace gird
+{
+
+namespace
+{
+
+uint32_t TrigramKey(const std::string &s, size_t i)
+{
+    return (static_cast<uint32_t>(static_cast<unsigned char>(s[i])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(s[i + 1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(s[i + 2]));
+}
+
+std::string Lower(const std::string &s)
+{
+    std::string out(s);
+    for (auto &ch : out)
+        ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    return out;
+}
+
+} // namespace
+
+TrigramIndex::Input TrigramIndex::Snapshot(int docCol, const TypedColumn &col)
+{
+    Input in;
+    in.docCol = docCol;
+    in.dict = col.dict;
+    in.codes = col.codes;
+    if (col.nullCount > 0)
+        in.nulls = col.nulls;
+    return in;
+}
+
+void TrigramIndex::Build(std::vector<Input> inputs, int rows, size_t budgetBytes)
+{
+    columns.clear();
+    rowCount = rows;
+    bytes = 0;
+
+    for (Input &in : inputs)
+    {
+        if (static_cast<int>(in.codes.size()) != rows)
+            continue;
+
+        // Upper bound before committing: text, (trigram, code) pairs while
+        // sorting, the postings they become, and the code -> rows table.
+        size_t textBytes = 0, maxPairs = 0;
+        for (const auto &s : in.dict)
+        {
+            textBytes += s.size();
+            maxPairs += s.size() >= 3 ? s.size() - 2 : 0;
+        }
+        const size_t estimate = textBytes + in.dict.size() * sizeof(std::string) +
+                                maxPairs * (sizeof(uint64_t) + 3 * sizeof(uint32_t)) +
+                                (in.dict.size() + 1 + static_cast<size_t>(rows)) * sizeof(uint32_t);
+        if (bytes + estimate > budgetBytes)
+            continue;
+
+        Column col;
+        col.docCol = in.docCol;
+        col.lowerDict.reserve(in.dict.size());
+        for (const auto &s : in.dict)
+            col.lowerDict.push_back(Lower(s));
+        in.dict = {};
+
+        // Postings: sort (trigram, code) pairs, dropping repeats inside a value
+        std::vector<uint64_t> pairs;
+        pairs.reserve(maxPairs);
+        for (uint32_t code = 0; code < col.lowerDict.size(); ++code)
+        {
+            const std::string &s = col.lowerDict[code];
+            for (size_t i = 0; i + 3 <= s.size(); ++i)
+                pairs.push_back((static_cast<uint64_t>(TrigramKey(s, i)) << 32) | code);
+        }
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        col.postings.reserve(pairs.size());
+        for (uint64_t p : pairs)
+        {
+            const auto key = static_cast<uint32_t>(p >> 32);
+            if (col.trigrams.empty() || col.trigrams.back() != key)
+            {
+                col.trigrams.push_back(key);
+                col.postingStart.push_back(static_cast<uint32_t>(col.postings.size()));
+            }
+            col.postings.push_back(static_cast<uint32_t>(p));
+        }
+        col.postingStart.push_back(static_cast<uint32_t>(col.postings.size()));
+        pairs = {};
+
+        // Rows by code (counting sort keeps each code's rows ascending)
+        col.rowStart.assign(col.lowerDict.size() + 1, 0);
+        const bool hasNulls = !in.nulls.words.empty();
+        for (int r = 0; r < rows; ++r)
+            if (!hasNulls || !in.nulls.Test(r))
+                ++col.rowStart[in.codes[r] + 1];
+        for (size_t c = 1; c < col.rowStart.size(); ++c)
+            col.rowStart[c] += col.rowStart[c - 1];
+        col.rows.resize(col.rowStart.back());
+        std::vector<uint32_t> fill(col.rowStart.begin(), col.rowStart.end() - 1);
+        for (int r = 0; r < rows; ++r)
+            if (!hasNulls || !in.nulls.Test(r))
+                col.rows[fill[in.codes[r]]++] = static_cast<uint32_t>(r);
+        in.codes = {};
+
+        for (const auto &s : col.lowerDict)
+            bytes += s.capacity() + sizeof(std::string);
+        bytes += (col.trigrams.capacity() + col.postingStart.capacity() + col.postings.capacity() +
+                  col.rowStart.capacity() + col.rows.capacity()) *
+                 sizeof(uint32_t);
+        columns.push_back(std::move(col));
+    }
+}
+
+const TrigramIndex::Column *TrigramIndex::Find(int docCol) const
+{
+    for (const auto &c : columns)
+        if (c.docCol == docCol)
+            return &c;
+    return nullptr;
+}
+
+bool TrigramIndex::Search(int docCol, const std::string &lowerNeedle, Bitmap &out,
+                          const Bitmap *mask) const
+{
+    const Column *col = Find(docCol);
+    if (!col || lowerNeedle.size() < 3)
+        return false;
+
+    out.Resize(rowCount, false);
+
+    // Posting list of every distinct trigram of the needle, shortest first
+    std::vector<uint32_t> keys;
+    for (size_t i = 0; i + 3 <= lowerNeedle.size(); ++i)
+        keys.push_back(TrigramKey(lowerNeedle, i));
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    struct Span
+    {
+        const uint32_t *begin, *end;
+    };
+    std::vector<Span> lists;
+    for (uint32_t key : keys)
+    {
+        auto it = std::lower_bound(col->trigrams.begin(), col->trigrams.end(), key);
+        if (it == col->trigrams.end() || *it != key)
+            return true; // a trigram no value has: no match
+        const size_t t = it - col->trigrams.begin();
+        lists.push_back({col->postings.data() + col->postingStart[t],
+                         col->postings.data() + col->postingStart[t + 1]});
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const Span &a, const Span &b) { return (a.end - a.begin) < (b.end - b.begin); });
+
+    std::vector<uint32_t> candidates(lists[0].begin, lists[0].end), next;
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i)
+    {
+        next.clear();
+        std::set_intersection(candidates.begin(), candidates.end(), lists[i].begin, lists[i].end,
+                              std::back_inserter(next));
+        candidates.swap(next);
+    }
+
+    // Trigrams only say "may contain": verify the candidate values, then expand
+    for (uint32_t code : candidates)
+    {
+        if (col->lowerDict[code].find(lowerNeedle) == std::string::npos)
+            continue;
+        for (uint32_t i = col->rowStart[code]; i < col->rowStart[code + 1]; ++i)
+        {
+            const auto r = static_cast<int>(col->rows[i]);
+            if (!mask || mask->Test(r))
+                out.Set(r);
+        }
+    }
+    return true;
+}
+
+} // namespace gird
@@ -0,0 +1,74 @@
+#pragma once
+#include "Bitmap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gird
+{
+
+struct TypedColumn;
+
+// ---- Trigram index over the text columns (quick text and find) ----
+// Built per String/Date column over its dictionary: every distinct value is
+// lower-cased and cut into 3-byte trigrams, each with a posting list of the
+// dictionary codes that contain it, plus a code -> rows table. A needle of 3+
+// characters intersects the postings of its trigrams (shortest first), checks
+// only those candidate values, and expands the hits to rows, so a search costs
+// in proportion to the matches rather than the table.
+//
+// Build() works on copies of the columns (Snapshot) so it can run on a worker
+// thread while the store keeps changing; `generation` tells the owner which
+// store contents it describes. Columns that would push the index past its
+// memory budget are left out, and Search() reports them so callers scan.
+class TrigramIndex
+{
+  public:
+    static constexpr size_t DefaultBudgetBytes = size_t(256) << 20;
+
+    struct Input
+    {
+        int docCol = -1;
+        std::vector<std::string> dict;
+        std::vector<uint32_t> codes;
+        Bitmap nulls; // empty = no nulls
+    };
+    // Copies what Build() needs from a store column (call on the owning thread).
+    [[nodiscard]] static Input Snapshot(int docCol, const TypedColumn &col);
+
+    void Build(std::vector<Input> inputs, int rows, size_t budgetBytes);
+
+    uint64_t generation = 0; // ColumnStore::Generation(text columns) at the snapshot
+
+    // Writes the rows of `docCol` whose text contains `lowerNeedle` into `out`
+    // (restricted to `mask` if given). Returns false, leaving `out` alone, if the
+    // column is not indexed or the needle is shorter than a trigram.
+    bool Search(int docCol, const std::string &lowerNeedle, Bitmap &out,
+                const Bitmap *mask = nullptr) const;
+
+    [[nodiscard]] bool Covers(int docCol) const { return Find(docCol) != nullptr; }
+    [[nodiscard]] int RowCount() const { return rowCount; }
+    [[nodiscard]] size_t MemoryBytes() const { return bytes; }
+
+  private:
+    struct Column
+    {
+        int docCol = -1;
+        std::vector<std::string> lowerDict;
+        std::vector<uint32_t> trigrams;     // sorted distinct trigram keys
+        std::vector<uint32_t> postingStart; // per trigram, +1 sentinel: offsets into postings
+        std::vector<uint32_t> postings;     // dictionary codes, ascending per trigram
+        std::vector<uint32_t> rowStart;     // per code, +1 sentinel: offsets into rows
+        std::vector<uint32_t> rows;         // non-null rows grouped by code, ascending
+    };
+
+    std::vector<Column> columns;
+    int rowCount = 0;
+    size_t bytes = 0;
+
+    [[nodiscard]] const Column *Find(int docCol) const;
+};
+
+} // namespace gird
@@ -4,6 +4,7 @@
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 
+#include "CustomAggregate.h"
 #include "GridFramework.h"
 #include "GridPersistence.h"
 #include "GridViewImGui.h"
@@ -45,15 +46,61 @@ struct AppState
     ImVec4 clear_color = ImVec4(0.10f, 0.10f, 0.12f, 1.00f);
 
     std::unique_ptr<gird::IPersistence> persistence;
+
+    // Idle rendering: source version of the last frame drawn, and frames still
+    // to draw before blocking again
+    uint64_t drawnVersion = 0;
+    int settleFrames = 0;
 };
 
 static AppState g;
 
+#ifndef __EMSCRIPTEN__
+// Polls while there is something to draw, else blocks until input, a wake
+// (ctl.wake: background job, data feed), a timed message expiring or the
+// minimum refresh is due. ImGui settles hover and navigation state over a
+// couple of frames, so a few more are drawn after each wake-up.
+static void WaitForEvents()
+{
+    constexpr int SettleFrames = 3;
+    constexpr double CaretBlinkSeconds = 0.25; // an active text field keeps blinking
+
+    const gird::GridPreferences &prefs = g.doc.prefs;
+    const double expiry = gird::TimeUntilUIExpiry();
+    const bool busy = !prefs.idleRendering || g.ctl.NeedsFrame() || g.src.Version() != g.drawnVersion ||
+                      ImGui::IsAnyMouseDown() || expiry == 0.0;
+    if (busy || g.settleFrames > 0)
+    {
+        g.settleFrames = busy ? SettleFrames : g.settleFrames - 1;
+        glfwPollEvents();
+        return;
+    }
+
+    double timeout = prefs.minRefreshHz > 0.0f ? 1.0 / prefs.minRefreshHz : 0.0;
+    if (ImGui::GetIO().WantTextInput && (timeout == 0.0 || timeout > CaretBlinkSeconds))
+        timeout = CaretBlinkSeconds;
+    if (expiry > 0.0 && (timeout == 0.0 || timeout > expiry))
+        timeout = expiry;
+
+    const double start = glfwGetTime();
+    if (timeout > 0.0)
+        glfwWaitEventsTimeout(timeout);
+    else
+        glfwWaitEvents();
+    if (timeout == 0.0 || glfwGetTime() - start < timeout)
+        g.settleFrames = SettleFrames; // woken by an event rather than the timeout
+}
+#endif
+
 
 
 static void Frame()
 {
-    glfwPollEvents();
+#ifdef __EMSCRIPTEN__
+    glfwPollEvents(); // the browser paces frames
+#else
+    WaitForEvents();
+#endif
     if (glfwGetWindowAttrib(g.window, GLFW_ICONIFIED) != 0)
     {
         ImGui_ImplGlfw_Sleep(10);
@@ -84,6 +131,7 @@ static void Frame()
 
     if (g.vm.dirtyIndices)
         g.ctl.RebuildIndices();
+    g.drawnVersion = g.src.Version();
 
     // Draw grid to fill remaining content region
     gird::DrawGridImGui(g.doc, g.vm, g.ctl, {ImGui::GetWindowWidth() - 10 , ImGui::GetWindowHeight() - 40});
@@ -168,6 +216,7 @@ int main(int, char**)
 
     // Build document columns
     BuildFinancialColumns(g.doc);
+    gird::RegisterBuiltinAggregates(g.doc);
 
     g.vm.groupByColumnIds = {};
     g.vm.dirtyGroups = true;
@@ -184,6 +233,10 @@ int main(int, char**)
     g.vm.persistenceKey = "main_grid";
     // NEW: Give controller access to persistence
     g.ctl.persistence = g.persistence.get();
+#ifndef __EMSCRIPTEN__
+    // Background results wake the event loop (idle rendering)
+    g.ctl.wake = [] { glfwPostEmptyEvent(); };
+#endif
 
 #ifdef __EMSCRIPTEN__
     // Typically disable ini on web; persistence can be added later.